@@ -0,0 +1,119 @@
+/*
+ * Allocation guard
+ *
+ * Interposes malloc() and friends to count heap traffic, forwarding to the
+ * glibc allocator. Every per-frame path is meant to run from buffers set up
+ * in advance, so once the game has warmed up no allocation should happen at
+ * all. "--alloc-guard N" enforces that: after the first N frames the guard
+ * is armed, and the next allocation prints a backtrace and aborts.
+ *
+ * When the guard is not in use this costs one counter increment and one
+ * predictable branch per allocation. The file is only built with
+ * "make ALLOC_GUARD=1", release builds keep plain malloc().
+ */
+
+#include <execinfo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "trex.h"
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static struct {
+    uint64_t allocations; /* malloc/calloc/realloc calls since startup */
+    int warmup;           /* Frames allowed to allocate, 0 when unused */
+    int arm_after;        /* Frames left before arming, -1 when unused */
+    bool armed;           /* Read by every allocating thread */
+} guard = {.arm_after = -1};
+
+static void alloc_violation(const char *func, size_t size)
+{
+    /* Reporting may allocate, which is fine from here on */
+    __atomic_store_n(&guard.armed, false, __ATOMIC_RELAXED);
+
+    fprintf(stderr, "alloc-guard: %s(%zu) after warm-up\n", func, size);
+
+    void *pc[32];
+    int depth = backtrace(pc, 32);
+    backtrace_symbols_fd(pc, depth, STDERR_FILENO);
+    abort();
+}
+
+static inline void alloc_note(const char *func, size_t size)
+{
+    __atomic_fetch_add(&guard.allocations, 1, __ATOMIC_RELAXED);
+    if (__builtin_expect(__atomic_load_n(&guard.armed, __ATOMIC_RELAXED), 0))
+        alloc_violation(func, size);
+}
+
+void *malloc(size_t size)
+{
+    alloc_note("malloc", size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    alloc_note("calloc", nmemb * size);
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    alloc_note("realloc", size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+
+/**
+ * Abort on any allocation once the given number of frames has passed
+ * @frames : Warm-up frames during which allocations are still allowed
+ */
+void alloc_guard_arm_after(int frames)
+{
+    /* backtrace() loads the unwinder on first use, not during a report */
+    void *pc[1];
+    backtrace(pc, 1);
+
+    guard.warmup = frames;
+    guard.arm_after = frames;
+}
+
+/* Start another warm-up, for events such as growing the screen buffers */
+void alloc_guard_rewarm(void)
+{
+    if (!guard.warmup)
+        return;
+
+    __atomic_store_n(&guard.armed, false, __ATOMIC_RELAXED);
+    guard.arm_after = guard.warmup;
+}
+
+/* Count a finished frame, arming the guard when warm-up is over */
+void alloc_guard_frame(void)
+{
+    if (guard.arm_after > 0 && --guard.arm_after == 0)
+        __atomic_store_n(&guard.armed, true, __ATOMIC_RELAXED);
+}
+
+/* Allow allocations again, for teardown and reporting */
+void alloc_guard_disarm(void)
+{
+    guard.warmup = 0;
+    guard.arm_after = -1;
+    __atomic_store_n(&guard.armed, false, __ATOMIC_RELAXED);
+}
+
+uint64_t alloc_count(void)
+{
+    return __atomic_load_n(&guard.allocations, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,466 @@
+/*
+ * Headless benchmark
+ *
+ * "trex --bench N" plays N frames of an autoplayed world as fast as possible
+ * on the headless backend: the full diff and VT encoding run, but the output
+ * goes to /dev/null. Wall time and performance counters are accumulated for
+ * each frame phase (world update, composition, tui_refresh) and reported at
+ * the end, so data-layout changes can be judged on IPC and cache behaviour
+ * rather than on frame times alone.
+ *
+ * The screen size and the world seed can be changed to bench other scenes;
+ * the autoplayer makes every run of a scene play exactly the same game.
+ *
+ * Counters are read with perf_event_open() as one group at every phase
+ * boundary. Hardware counters are preferred; where they are unavailable, as
+ * in many containers, software counters are used instead.
+ */
+
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "probe.h"
+#include "trex.h"
+
+#define BENCH_ROWS 50
+#define BENCH_COLS 160
+#define BENCH_SEED 1
+#define BENCH_MAX_EVENTS 4
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+typedef enum {
+    BENCH_UPDATE,
+    BENCH_COMPOSE,
+    BENCH_REFRESH,
+    BENCH_PHASES
+} bench_phase_t;
+
+typedef struct {
+    uint32_t type;
+    uint64_t config;
+    const char *name;
+} bench_event_t;
+
+static const bench_event_t hw_events[] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instr"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "cache-miss"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch-miss"},
+};
+
+static const bench_event_t sw_events[] = {
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, "task-ns"},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, "faults"},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "ctx-sw"},
+};
+
+static const char *const phase_names[BENCH_PHASES] = {
+    [BENCH_UPDATE] = "update",
+    [BENCH_COMPOSE] = "compose",
+    [BENCH_REFRESH] = "refresh",
+};
+
+static struct {
+    int rows, cols;
+    unsigned int seed;
+
+    const bench_event_t *events;
+    int nevents;    /* 0 when no counters could be opened */
+    bool user_only; /* Kernel time is not counted by software events */
+    int fds[BENCH_MAX_EVENTS];
+
+    double time_ms[BENCH_PHASES];
+    uint64_t counts[BENCH_PHASES][BENCH_MAX_EVENTS];
+} bench = {.rows = BENCH_ROWS, .cols = BENCH_COLS, .seed = BENCH_SEED};
+
+static int perf_open(const bench_event_t *event, int group_fd)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event->type;
+    attr.config = event->config;
+    attr.disabled = group_fd == -1; /* The leader starts the group */
+    /* Context switches and write() happen in the kernel, count them */
+    attr.exclude_kernel = event->type == PERF_TYPE_HARDWARE || bench.user_only;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static void perf_close(void)
+{
+    for (int i = 0; i < bench.nevents; i++)
+        close(bench.fds[i]);
+    bench.nevents = 0;
+}
+
+/* Open the events as one group, all or nothing */
+static bool perf_open_group(const bench_event_t *events, int count)
+{
+    bench.events = events;
+    for (int i = 0; i < count; i++) {
+        int fd = perf_open(&events[i], i ? bench.fds[0] : -1);
+        if (fd == -1) {
+            perf_close();
+            return false;
+        }
+        bench.fds[bench.nevents++] = fd;
+    }
+
+    ioctl(bench.fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(bench.fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+/* Read all counters of the group with a single system call */
+static void perf_read(uint64_t *values)
+{
+    struct {
+        uint64_t nr;
+        uint64_t values[BENCH_MAX_EVENTS];
+    } group;
+
+    if (!bench.nevents)
+        return;
+    if (read(bench.fds[0], &group, sizeof(group)) < (ssize_t) sizeof(group.nr))
+        return;
+
+    for (uint64_t i = 0; i < group.nr && i < BENCH_MAX_EVENTS; i++)
+        values[i] = group.values[i];
+}
+
+/* Charge the time and counts since the previous sample to a phase */
+static void bench_sample(bench_phase_t phase, double *last_ms, uint64_t *last)
+{
+    uint64_t now[BENCH_MAX_EVENTS] = {0};
+    perf_read(now);
+    double now_ms = state_get_time_ms();
+
+    bench.time_ms[phase] += now_ms - *last_ms;
+    for (int i = 0; i < bench.nevents; i++)
+        bench.counts[phase][i] += now[i] - last[i];
+
+    *last_ms = now_ms;
+    memcpy(last, now, sizeof(now));
+}
+
+static void bench_report(int frames,
+                         double elapsed_ms,
+                         uint64_t allocs,
+                         const tui_footprint_t *fp,
+                         const tui_stats_t *out)
+{
+    printf("bench: %d frames, %dx%d, seed %u, %.2f s (%.0f frames/s)\n",
+           frames, bench.rows, bench.cols, bench.seed, elapsed_ms / 1000.0,
+           frames * 1000.0 / elapsed_ms);
+#ifdef ALLOC_GUARD
+    printf("heap: %llu allocations during the run\n",
+           (unsigned long long) allocs);
+#else
+    (void) allocs;
+    printf("heap: not counted, build with ALLOC_GUARD=1\n");
+#endif
+    printf("memory: renderer %zu bytes, %zu KiB private, %zu KiB resident\n",
+           fp->total, fp->anon_kb, fp->rss_kb);
+    printf("output: %.0f bytes in %.1f writes per frame\n",
+           (double) out->bytes / frames, (double) out->writes / frames);
+
+    if (!bench.nevents)
+        printf("counters: unavailable\n");
+    else if (bench.events == hw_events)
+        printf("counters: hardware, per frame\n");
+    else if (bench.user_only)
+        printf("counters: software, user time only, per frame\n");
+    else
+        printf("counters: software (no hardware counters), per frame\n");
+
+    printf("%-8s %9s", "phase", "ms");
+    for (int i = 0; i < bench.nevents; i++)
+        printf(" %12s", bench.events[i].name);
+    if (bench.events == hw_events && bench.nevents)
+        printf(" %5s", "IPC");
+    printf("\n");
+
+    for (int p = 0; p < BENCH_PHASES; p++) {
+        const uint64_t *counts = bench.counts[p];
+
+        printf("%-8s %9.4f", phase_names[p], bench.time_ms[p] / frames);
+        for (int i = 0; i < bench.nevents; i++)
+            printf(" %12.1f", (double) counts[i] / frames);
+        if (bench.events == hw_events && bench.nevents)
+            printf(" %5.2f",
+                   counts[0] ? (double) counts[1] / counts[0] : 0.0);
+        printf("\n");
+    }
+}
+
+/**
+ * Choose the scene played by bench_run()
+ * @rows : Screen rows
+ * @cols : Screen columns
+ * @seed : Seed of the autoplayed world
+ */
+void bench_set_scene(int rows, int cols, unsigned int seed)
+{
+    bench.rows = rows;
+    bench.cols = cols;
+    bench.seed = seed;
+}
+
+/* Headless screen and autoplayed world of the scene */
+static world_t *bench_open(void)
+{
+    tui_set_backend(TUI_BACKEND_HEADLESS);
+    tui_set_headless_size(bench.rows, bench.cols);
+    if (!tui_init()) {
+        fprintf(stderr, "bench: failed to initialize the headless screen\n");
+        return NULL;
+    }
+    tui_start_color();
+    tui_init_pair(1, TUI_COLOR_GREEN, TUI_COLOR_BLACK);
+    draw_init_buffers();
+
+    world_t *w = play_world_new(bench.rows, bench.cols, bench.seed);
+    if (!w)
+        tui_cleanup();
+    return w;
+}
+
+static void bench_close(world_t *w)
+{
+    play_world_free(w);
+    draw_cleanup_buffers();
+    draw_cleanup_colors();
+    tui_cleanup();
+}
+
+/* Play one frame of the autoplayer, starting over after each death */
+static void bench_update(world_t *w)
+{
+    const game_config_t *cfg = ensure_cfg();
+
+    int key = play_world_bot_input(w);
+    if (key != -1)
+        play_world_handle_input(w, key);
+    play_world_update(w, cfg->timing.frame_time * NS_PER_MS);
+    if (play_world_is_dead(w))
+        play_world_reset(w);
+}
+
+/**
+ * Run the headless benchmark and print the report on stdout
+ * @frames : Number of frames to play
+ */
+int bench_run(int frames)
+{
+    world_t *w = bench_open();
+    if (!w)
+        return 1;
+
+    /* Counting kernel time may be forbidden by perf_event_paranoid */
+    if (!perf_open_group(hw_events, ARRAY_SIZE(hw_events)) &&
+        !perf_open_group(sw_events, ARRAY_SIZE(sw_events))) {
+        bench.user_only = true;
+        perf_open_group(sw_events, ARRAY_SIZE(sw_events));
+    }
+
+    uint64_t last[BENCH_MAX_EVENTS] = {0};
+    perf_read(last);
+    double start_ms = state_get_time_ms(), last_ms = start_ms;
+    uint64_t start_allocs = alloc_count();
+    tui_stats_t start_out;
+    tui_get_stats(&start_out);
+
+    for (int i = 0; i < frames; i++) {
+        tui_check_shutdown();
+        PROBE(frame_begin);
+
+        TRACE_BEGIN("update");
+        bench_update(w);
+        TRACE_END("update");
+        bench_sample(BENCH_UPDATE, &last_ms, last);
+
+        TRACE_BEGIN("compose");
+        draw_clear_back_buffer();
+        play_world_render(w);
+        TRACE_END("compose");
+        bench_sample(BENCH_COMPOSE, &last_ms, last);
+
+        draw_swap_buffers();
+        bench_sample(BENCH_REFRESH, &last_ms, last);
+        PROBE1(frame_end, i);
+
+        alloc_guard_frame();
+    }
+
+    double elapsed_ms = state_get_time_ms() - start_ms;
+    uint64_t allocs = alloc_count() - start_allocs;
+
+    tui_footprint_t fp;
+    tui_get_footprint(&fp);
+    tui_stats_t out;
+    tui_get_stats(&out);
+    out.bytes -= start_out.bytes;
+    out.writes -= start_out.writes;
+
+    alloc_guard_disarm();
+    bench_report(frames, elapsed_ms, allocs, &fp, &out);
+
+    perf_close();
+    bench_close(w);
+    return 0;
+}
+
+/* One sample of the soak test per minute of game time */
+typedef enum {
+    SOAK_P99,
+    SOAK_ANON,
+    SOAK_ESC,
+    SOAK_PAIRS,
+    SOAK_COLORS,
+    SOAK_METRICS
+} soak_metric_t;
+
+static const struct {
+    const char *name;
+    bool noisy;   /* Compare medians instead of maxima */
+    double ratio; /* Allowed growth of the late half over the early half */
+    double slack;
+} soak_metrics[SOAK_METRICS] = {
+    [SOAK_P99] = {"p99-ms", true, 1.25, 0.05},
+    [SOAK_ANON] = {"anon-kb", false, 1.0, 64},
+    [SOAK_ESC] = {"esc", false, 1.0, 0},
+    [SOAK_PAIRS] = {"pairs", false, 1.0, 0},
+    [SOAK_COLORS] = {"colors", false, 1.0, 0},
+};
+
+#define SOAK_MAX_MINUTES (24 * 60)
+#define SOAK_FRAMES_PER_MINUTE 3600 /* At the nominal 60 frames/s */
+
+#define SOAK_TAIL (SOAK_FRAMES_PER_MINUTE / 100) /* Frames above the p99 */
+
+static float soak_slowest[SOAK_TAIL + 1]; /* Of the minute, descending */
+static double soak_samples[SOAK_METRICS][SOAK_MAX_MINUTES];
+static double soak_sorted[SOAK_MAX_MINUTES];
+
+static int double_cmp(const void *a, const void *b)
+{
+    double da = *(const double *) a, db = *(const double *) b;
+    return (da > db) - (da < db);
+}
+
+/* Keep the slowest frames of the minute, qsort() would allocate */
+static void soak_note_frame(float ms)
+{
+    int i = SOAK_TAIL;
+    if (ms <= soak_slowest[i])
+        return;
+
+    for (; i > 0 && soak_slowest[i - 1] < ms; i--)
+        soak_slowest[i] = soak_slowest[i - 1];
+    soak_slowest[i] = ms;
+}
+
+/* Median or maximum of samples [from, to) of a metric */
+static double soak_level(soak_metric_t m, int from, int to)
+{
+    memcpy(soak_sorted, &soak_samples[m][from], (to - from) * sizeof(double));
+    qsort(soak_sorted, to - from, sizeof(double), double_cmp);
+    return soak_metrics[m].noisy ? soak_sorted[(to - from) / 2]
+                                 : soak_sorted[to - from - 1];
+}
+
+/**
+ * Play the autoplayer for hours of game time and look for drift
+ * @minutes : Minutes of game time, played as fast as possible
+ *
+ * Every minute, the p99 frame time, the private memory and the size of the
+ * caches that never evict are sampled. The first quarter of the run is
+ * warm-up; a metric whose level in the last half of the rest exceeds the
+ * level in the first half is reported as a trend. Returns 1 if any metric
+ * trends upward.
+ */
+int bench_soak(int minutes)
+{
+    if (minutes < 4 || minutes > SOAK_MAX_MINUTES) {
+        fprintf(stderr, "soak: between 4 and %d minutes\n", SOAK_MAX_MINUTES);
+        return 1;
+    }
+
+    world_t *w = bench_open();
+    if (!w)
+        return 1;
+
+    printf("soak: %d minutes of game time, %dx%d, seed %u\n", minutes,
+           bench.rows, bench.cols, bench.seed);
+    printf("%6s", "minute");
+    for (int m = 0; m < SOAK_METRICS; m++)
+        printf(" %8s", soak_metrics[m].name);
+    printf("\n");
+    fflush(stdout);
+
+    double start_ms = state_get_time_ms();
+    for (int minute = 0; minute < minutes; minute++) {
+        memset(soak_slowest, 0, sizeof(soak_slowest));
+        for (int i = 0; i < SOAK_FRAMES_PER_MINUTE; i++) {
+            tui_check_shutdown();
+
+            double frame_start = state_get_time_ms();
+            bench_update(w);
+            draw_clear_back_buffer();
+            play_world_render(w);
+            draw_swap_buffers();
+            soak_note_frame(state_get_time_ms() - frame_start);
+
+            alloc_guard_frame();
+        }
+
+        tui_footprint_t fp;
+        tui_stats_t stats;
+        tui_get_footprint(&fp);
+        tui_get_stats(&stats);
+
+        double *sample[SOAK_METRICS];
+        for (int m = 0; m < SOAK_METRICS; m++)
+            sample[m] = &soak_samples[m][minute];
+        *sample[SOAK_P99] = soak_slowest[SOAK_TAIL];
+        *sample[SOAK_ANON] = fp.anon_kb;
+        *sample[SOAK_ESC] = stats.esc_interned;
+        *sample[SOAK_PAIRS] = stats.pairs_used;
+        *sample[SOAK_COLORS] = draw_get_color_count();
+
+        printf("%6d %8.3f", minute + 1, *sample[SOAK_P99]);
+        for (int m = SOAK_ANON; m < SOAK_METRICS; m++)
+            printf(" %8.0f", *sample[m]);
+        printf("\n");
+        fflush(stdout);
+    }
+
+    alloc_guard_disarm();
+    bench_close(w);
+
+    int warmup = minutes / 4, middle = warmup + (minutes - warmup) / 2;
+    int trends = 0;
+    for (int m = 0; m < SOAK_METRICS; m++) {
+        double early = soak_level(m, warmup, middle);
+        double late = soak_level(m, middle, minutes);
+        if (late > early * soak_metrics[m].ratio + soak_metrics[m].slack) {
+            printf("soak: %s trends upward, %g in minutes %d-%d, %g in "
+                   "minutes %d-%d\n",
+                   soak_metrics[m].name, early, warmup + 1, middle, late,
+                   middle + 1, minutes);
+            trends++;
+        }
+    }
+    printf("soak: %s after %.0f s\n", trends ? "FAIL" : "ok",
+           (state_get_time_ms() - start_ms) / 1000.0);
+    return trends ? 1 : 0;
+}
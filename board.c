@@ -0,0 +1,182 @@
+/*
+ * High-score table shared by all sessions on a host
+ *
+ * The table is a small file mapped into every session. Each slot is one
+ * 64-bit word holding a score and the time it was set, packed so that a
+ * larger word is a better entry, and an empty slot is zero. The slots are
+ * kept unsorted:
+ *
+ * - A new score replaces the smallest slot with a compare-and-swap, if it
+ *   beats it. Slots only ever grow, so the smallest slot seen by a scan is
+ *   still no larger than any other when the swap succeeds; a failed swap
+ *   means another session got there first and the scan starts over.
+ * - Readers load every slot and sort the copy.
+ *
+ * There are no locks and, once the file is mapped, no system calls: a
+ * session that loses every race gives up after BOARD_RETRIES scans rather
+ * than hold up a frame. The file blocks are allocated at open, so the first
+ * score does not take a fault that allocates them either.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trex.h"
+
+#define BOARD_MAGIC 0x31445254u /* "TRD1", the digit is the layout version */
+#define BOARD_RETRIES 64
+
+typedef struct {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t slots[BOARD_SLOTS];
+} board_file_t;
+
+static struct {
+    board_file_t *file;
+    uint64_t mine; /* Last entry of this session */
+    int mine_slot; /* and where it went, -1 for none */
+} board = {.mine_slot = -1};
+
+/* Higher scores sort first, then the more recent of two equal ones */
+static uint64_t pack_entry(int score, int64_t when)
+{
+    return (uint64_t) score << 32 | (uint32_t) when;
+}
+
+/**
+ * Map the table, creating the file if needed
+ * @path : Table file, the same one for every session that competes
+ *
+ * Every session maps the file for writing, so it is created 0666 less the
+ * umask; a table shared by several users needs a umask, or a mode set by
+ * hand, that lets all of them write it.
+ *
+ * Returns false if the file cannot be used, scores are then not kept.
+ */
+bool board_open(const char *path)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd == -1)
+        return false;
+
+    /* Extend a new file with real blocks rather than a hole, keeping
+     * whatever a session that raced us to create it has written
+     */
+    if (posix_fallocate(fd, 0, sizeof(board_file_t))) {
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(NULL, sizeof(board_file_t), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    /* Whoever comes first stamps the header, everyone else checks it */
+    board_file_t *file = map;
+    uint32_t magic = 0;
+    if (!__atomic_compare_exchange_n(&file->magic, &magic, BOARD_MAGIC, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) &&
+        magic != BOARD_MAGIC) {
+        munmap(map, sizeof(board_file_t));
+        return false;
+    }
+
+    board.file = file;
+    return true;
+}
+
+void board_close(void)
+{
+    if (!board.file)
+        return;
+
+    munmap(board.file, sizeof(board_file_t));
+    board.file = NULL;
+    board.mine_slot = -1;
+}
+
+/**
+ * Enter a finished game into the table
+ * @score : Final score
+ *
+ * Returns true if the score made it into the table.
+ */
+bool board_submit(int score)
+{
+    if (!board.file || score <= 0)
+        return false;
+
+    uint64_t entry = pack_entry(score, time(NULL));
+    uint64_t *slots = board.file->slots;
+
+    for (int tries = 0; tries < BOARD_RETRIES; tries++) {
+        int lowest = 0;
+        uint64_t low = __atomic_load_n(&slots[0], __ATOMIC_RELAXED);
+        for (int i = 1; i < BOARD_SLOTS; i++) {
+            uint64_t v = __atomic_load_n(&slots[i], __ATOMIC_RELAXED);
+            if (v < low) {
+                low = v;
+                lowest = i;
+            }
+        }
+        if (entry <= low)
+            return false;
+
+        if (__atomic_compare_exchange_n(&slots[lowest], &low, entry, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            board.mine = entry;
+            board.mine_slot = lowest;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Copy the table, best entry first
+ * @entries : Up to BOARD_SLOTS entries
+ *
+ * Returns the number of entries, zero without a table.
+ */
+int board_read(board_entry_t *entries)
+{
+    if (!board.file)
+        return 0;
+
+    /* Insertion sort of the non-empty slots, largest first. Another session
+     * may post the same score in the same second, so an entry is ours only
+     * if it is still in the slot we wrote; a slot never takes an equal value.
+     */
+    uint64_t sorted[BOARD_SLOTS];
+    bool mine[BOARD_SLOTS];
+    int count = 0;
+    for (int i = 0; i < BOARD_SLOTS; i++) {
+        uint64_t v = __atomic_load_n(&board.file->slots[i], __ATOMIC_ACQUIRE);
+        if (!v)
+            continue;
+
+        int j = count++;
+        for (; j > 0 && sorted[j - 1] < v; j--) {
+            sorted[j] = sorted[j - 1];
+            mine[j] = mine[j - 1];
+        }
+        sorted[j] = v;
+        mine[j] = i == board.mine_slot && v == board.mine;
+    }
+
+    for (int i = 0; i < count; i++) {
+        entries[i] = (board_entry_t) {
+            .score = (int) (sorted[i] >> 32),
+            .when = (uint32_t) sorted[i],
+            .mine = mine[i],
+        };
+    }
+    return count;
+}
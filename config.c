@@ -91,18 +91,68 @@ static const game_config_t game_config = {
     .limits = {.max_level = 10, .max_objects = 100, .object_types = 6},
 };
 
-/* Level configuration data */
+/* Level configuration data, speeds in 1/SPEED_ONE cells per update */
 static const level_config_t level_configs[] = {
-    {.level = 1, .spawn_min = 1200, .spawn_max = 3000, .score_next = 100},
-    {.level = 2, .spawn_min = 1200, .spawn_max = 2500, .score_next = 150},
-    {.level = 3, .spawn_min = 1000, .spawn_max = 2200, .score_next = 200},
-    {.level = 4, .spawn_min = 1000, .spawn_max = 2000, .score_next = 250},
-    {.level = 5, .spawn_min = 1000, .spawn_max = 1900, .score_next = 270},
-    {.level = 6, .spawn_min = 1000, .spawn_max = 1800, .score_next = 300},
-    {.level = 7, .spawn_min = 1000, .spawn_max = 1700, .score_next = 350},
-    {.level = 8, .spawn_min = 800, .spawn_max = 1700, .score_next = 400},
-    {.level = 9, .spawn_min = 800, .spawn_max = 1600, .score_next = 450},
-    {.level = 10, .spawn_min = 800, .spawn_max = 1500, .score_next = 500},
+    {.level = 1,
+     .spawn_min = 1200,
+     .spawn_max = 3000,
+     .score_next = 100,
+     .speed_start = 256,
+     .speed_end = 272},
+    {.level = 2,
+     .spawn_min = 1200,
+     .spawn_max = 2500,
+     .score_next = 150,
+     .speed_start = 272,
+     .speed_end = 288},
+    {.level = 3,
+     .spawn_min = 1000,
+     .spawn_max = 2200,
+     .score_next = 200,
+     .speed_start = 288,
+     .speed_end = 320},
+    {.level = 4,
+     .spawn_min = 1000,
+     .spawn_max = 2000,
+     .score_next = 250,
+     .speed_start = 320,
+     .speed_end = 352},
+    {.level = 5,
+     .spawn_min = 1000,
+     .spawn_max = 1900,
+     .score_next = 270,
+     .speed_start = 352,
+     .speed_end = 384},
+    {.level = 6,
+     .spawn_min = 1000,
+     .spawn_max = 1800,
+     .score_next = 300,
+     .speed_start = 384,
+     .speed_end = 416},
+    {.level = 7,
+     .spawn_min = 1000,
+     .spawn_max = 1700,
+     .score_next = 350,
+     .speed_start = 416,
+     .speed_end = 448},
+    {.level = 8,
+     .spawn_min = 800,
+     .spawn_max = 1700,
+     .score_next = 400,
+     .speed_start = 448,
+     .speed_end = 480},
+    {.level = 9,
+     .spawn_min = 800,
+     .spawn_max = 1600,
+     .score_next = 450,
+     .speed_start = 480,
+     .speed_end = 512},
+    {.level = 10,
+     .spawn_min = 800,
+     .spawn_max = 1500,
+     .score_next = 500,
+     .speed_start = 512,
+     .speed_end = 576},
 };
 
 /* Object probability configuration */
@@ -1,3 +1,5 @@
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -10,6 +12,10 @@ static color_t **v_text_colors = NULL;
 static int total_block_colors = 0;
 static color_t **v_block_colors = NULL;
 
+/* Storage for registered colors, slot i backs v_*_colors[i] */
+static color_t *text_color_pool = NULL;
+static color_t *block_color_pool = NULL;
+
 /* Configuration is now handled globally via ensure_cfg() in config.h */
 
 /* Double buffering */
@@ -20,10 +26,35 @@ static int dirty_min_x = 0, dirty_min_y = 0;
 static int dirty_max_x = 0, dirty_max_y = 0;
 static bool has_dirty_region = false;
 
-/* Helper function to create and initialize a color */
-static color_t *create_color(short r, short g, short b, int color_id)
+/* Window the calling thread draws into, NULL selects the back buffer */
+static __thread tui_window_t *draw_target = NULL;
+
+/* Color registration may happen from several drawing threads at once */
+static pthread_mutex_t color_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Per-thread memo of resolved colors, so that steady-state lookups from
+ * worker threads neither scan the registry nor take color_lock. Entries are
+ * invalidated by bumping color_generation.
+ */
+#define COLOR_MEMO_SIZE 64
+
+typedef struct {
+    uint64_t key;
+    unsigned int generation;
+    int color_id;
+} color_memo_t;
+
+static __thread color_memo_t color_memo[COLOR_MEMO_SIZE];
+static uint64_t color_misses; /* Memo misses, for the flight recorder */
+static unsigned int color_generation = 1;
+
+/* Helper function to initialize a color in its preallocated slot */
+static color_t *create_color(color_t *new_color,
+                             short r,
+                             short g,
+                             short b,
+                             int color_id)
 {
-    color_t *new_color = malloc(sizeof(color_t));
     if (!new_color)
         return NULL;
 
@@ -35,14 +66,14 @@ static color_t *create_color(short r, short g, short b, int color_id)
     return new_color;
 }
 
-int draw_get_color_id(color_t **colors,
-                      short r,
-                      short g,
-                      short b,
-                      short r2,
-                      short g2,
-                      short b2,
-                      color_type_t type)
+static int lookup_color_id(color_t **colors,
+                           short r,
+                           short g,
+                           short b,
+                           short r2,
+                           short g2,
+                           short b2,
+                           color_type_t type)
 {
     const game_config_t *cfg = ensure_cfg();
 
@@ -66,6 +97,7 @@ int draw_get_color_id(color_t **colors,
     int color_id = -1;
     int *counter = NULL;
     color_t ***array = NULL;
+    color_t *pool = NULL;
 
     switch (type) {
     case COLOR_TYPE_TEXT:
@@ -74,6 +106,7 @@ int draw_get_color_id(color_t **colors,
         color_id = cfg->render.text_base + total_text_colors;
         counter = &total_text_colors;
         array = &v_text_colors;
+        pool = text_color_pool;
         break;
 
     case COLOR_TYPE_BLOCK:
@@ -82,6 +115,7 @@ int draw_get_color_id(color_t **colors,
         color_id = cfg->render.block_base + total_block_colors;
         counter = &total_block_colors;
         array = &v_block_colors;
+        pool = block_color_pool;
         break;
 
     case COLOR_TYPE_TEXT_WITH_BG:
@@ -90,12 +124,14 @@ int draw_get_color_id(color_t **colors,
         color_id = cfg->render.text_bg_base + total_text_colors;
         counter = &total_text_colors;
         array = &v_text_colors;
+        pool = text_color_pool;
         break;
     }
 
     /* Create color structure */
     new_color =
-        create_color((type == COLOR_TYPE_TEXT_WITH_BG) ? r + r2 : r,
+        create_color(pool ? &pool[*counter] : NULL,
+                     (type == COLOR_TYPE_TEXT_WITH_BG) ? r + r2 : r,
                      (type == COLOR_TYPE_TEXT_WITH_BG) ? g + g2 : g,
                      (type == COLOR_TYPE_TEXT_WITH_BG) ? b + b2 : b, color_id);
 
@@ -135,8 +171,48 @@ int draw_get_color_id(color_t **colors,
     return -1;
 }
 
-/* Render buffer management */
-void draw_init_buffers(void)
+int draw_get_color_id(color_t **colors,
+                      short r,
+                      short g,
+                      short b,
+                      short r2,
+                      short g2,
+                      short b2,
+                      color_type_t type)
+{
+    uint64_t fg = ((r & 0xFF) << 16) | ((g & 0xFF) << 8) | (b & 0xFF);
+    uint64_t bg = ((r2 & 0xFF) << 16) | ((g2 & 0xFF) << 8) | (b2 & 0xFF);
+    uint64_t key = ((uint64_t) type << 48) | (fg << 24) | bg;
+    unsigned int generation =
+        __atomic_load_n(&color_generation, __ATOMIC_ACQUIRE);
+    color_memo_t *memo = &color_memo[(key * 0x9E3779B97F4A7C15ULL) >> 58];
+
+    if (memo->generation == generation && memo->key == key)
+        return memo->color_id;
+
+    __atomic_fetch_add(&color_misses, 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&color_lock);
+    int color_id = lookup_color_id(colors, r, g, b, r2, g2, b2, type);
+    pthread_mutex_unlock(&color_lock);
+
+    /* Failures are retried, the registry may have room later */
+    if (color_id >= 0) {
+        memo->key = key;
+        memo->generation = generation;
+        memo->color_id = color_id;
+    }
+
+    return color_id;
+}
+
+uint64_t draw_get_color_misses(void)
+{
+    return __atomic_load_n(&color_misses, __ATOMIC_RELAXED);
+}
+
+/* Colors are registered while playing, so reserve their storage up front */
+static void reserve_colors(void)
 {
     const game_config_t *cfg = ensure_cfg();
 
@@ -146,6 +222,25 @@ void draw_init_buffers(void)
     if (!v_block_colors)
         v_block_colors = calloc(cfg->render.max_colors, sizeof(color_t *));
 
+    if (!text_color_pool)
+        text_color_pool = calloc(cfg->render.max_colors, sizeof(color_t));
+    if (!block_color_pool)
+        block_color_pool = calloc(cfg->render.max_colors, sizeof(color_t));
+}
+
+int draw_get_color_count(void)
+{
+    pthread_mutex_lock(&color_lock);
+    int count = total_text_colors + total_block_colors;
+    pthread_mutex_unlock(&color_lock);
+    return count;
+}
+
+/* Render buffer management */
+void draw_init_buffers(void)
+{
+    reserve_colors();
+
     render_buffer.front_buffer = tui_stdscr;
     render_buffer.back_buffer = tui_stdscr;
 
@@ -181,13 +276,24 @@ void draw_swap_buffers(void)
     }
 }
 
+void draw_set_target(tui_window_t *win)
+{
+    draw_target = win;
+}
+
 static tui_window_t *get_draw_buffer(void)
 {
+    if (draw_target)
+        return draw_target;
     return render_buffer.back_buffer ? render_buffer.back_buffer : tui_stdscr;
 }
 
 static void mark_dirty(int x, int y, int width, int height)
 {
+    /* Target windows track their own dirty rows */
+    if (draw_target)
+        return;
+
     if (!has_dirty_region) {
         dirty_min_x = x;
         dirty_min_y = y;
@@ -251,12 +357,7 @@ void draw_block(int x, int y, int cols, int rows, int flags)
 {
     tui_window_t *buffer = get_draw_buffer();
     tui_wattron(buffer, flags);
-
-    for (int j = 0; j < rows; ++j) {
-        for (int i = 0; i < cols; ++i)
-            tui_print_at(buffer, y + j, x + i, " ");
-    }
-
+    tui_fill(buffer, y, x, rows, cols, ' ');
     tui_wattroff(buffer, flags);
 
     mark_dirty(x, y, cols, rows);
@@ -275,11 +376,7 @@ void draw_block_color(int x,
         draw_get_color_id(v_block_colors, r, g, b, 0, 0, 0, COLOR_TYPE_BLOCK);
 
     tui_wattron(buffer, TUI_COLOR_PAIR(color_pair));
-
-    for (int j = 0; j < rows; ++j)
-        for (int i = 0; i < cols; ++i)
-            tui_print_at(buffer, y + j, x + i, " ");
-
+    tui_fill(buffer, y, x, rows, cols, ' ');
     tui_wattroff(buffer, TUI_COLOR_PAIR(color_pair));
 
     mark_dirty(x, y, cols, rows);
@@ -342,25 +439,39 @@ void draw_logo(int x, int y)
 /* Color management cleanup */
 void draw_cleanup_colors(void)
 {
-    /* Free all text colors */
+    /* Release all text colors, their slots stay in the pool */
     const game_config_t *cfg = ensure_cfg();
 
-    for (int i = 0; i < total_text_colors && i < cfg->render.max_colors; i++) {
-        if (v_text_colors[i]) {
-            free(v_text_colors[i]);
-            v_text_colors[i] = NULL;
-        }
-    }
+    for (int i = 0; i < total_text_colors && i < cfg->render.max_colors; i++)
+        v_text_colors[i] = NULL;
 
-    /* Free all block colors */
-    for (int i = 0; i < total_block_colors && i < cfg->render.max_colors; i++) {
-        if (v_block_colors[i]) {
-            free(v_block_colors[i]);
-            v_block_colors[i] = NULL;
-        }
-    }
+    /* Release all block colors */
+    for (int i = 0; i < total_block_colors && i < cfg->render.max_colors; i++)
+        v_block_colors[i] = NULL;
 
     /* Reset counters */
     total_text_colors = 0;
     total_block_colors = 0;
+
+    /* Drop memoized color IDs in every thread */
+    __atomic_add_fetch(&color_generation, 1, __ATOMIC_RELEASE);
+}
+
+/* Forget all colors and free their storage, see draw_wake() */
+void draw_hibernate(void)
+{
+    draw_cleanup_colors();
+
+    free(v_text_colors);
+    free(v_block_colors);
+    free(text_color_pool);
+    free(block_color_pool);
+    v_text_colors = v_block_colors = NULL;
+    text_color_pool = block_color_pool = NULL;
+}
+
+/* Colors are registered again as the next frame draws them */
+void draw_wake(void)
+{
+    reserve_colors();
 }
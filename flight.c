@@ -0,0 +1,153 @@
+/*
+ * Slow-frame flight recorder
+ *
+ * Keeps detailed statistics of the most recent frames in a fixed ring: time
+ * spent in each phase, terminal output, dirty cells, live objects and cache
+ * misses. When a frame runs over budget, the whole ring, ending with the
+ * offending frame, is appended to the dump file. Hitches are rare and get
+ * lost in averages; this captures the frames leading up to them.
+ *
+ * After a dump, the next one is held back until the ring has been refilled
+ * with new frames, so a burst of slow frames (including the one slowed down
+ * by the dump itself) does not flood the file.
+ */
+
+#include <stdio.h>
+
+#include "trex.h"
+
+#define FLIGHT_FRAMES 256
+
+typedef struct {
+    uint64_t seq;
+    float total_ms;
+    float phase_ms[FLIGHT_PHASES];
+    uint32_t writes, bytes, dirty_cells, objects;
+    uint32_t esc_misses, pair_misses, color_misses;
+} flight_frame_t;
+
+static const char *const phase_names[FLIGHT_PHASES] = {
+    [FLIGHT_INPUT] = "input",
+    [FLIGHT_UPDATE] = "update",
+    [FLIGHT_COMPOSE] = "compose",
+    [FLIGHT_REFRESH] = "refresh",
+};
+
+static struct {
+    bool enabled;
+    const char *path;
+    double budget_ms;
+
+    flight_frame_t frames[FLIGHT_FRAMES];
+    uint64_t seq;       /* Frames recorded so far */
+    uint64_t next_dump; /* First frame that may trigger a dump */
+
+    /* Current frame */
+    double frame_start, last_mark;
+    float phase_ms[FLIGHT_PHASES];
+    tui_stats_t last_stats;
+    uint64_t last_color_misses;
+} flight;
+
+/**
+ * Start recording frame statistics
+ * @path : File that slow frames are appended to
+ * @budget_ms : Frames taking longer than this are dumped
+ */
+void flight_open(const char *path, double budget_ms)
+{
+    flight.path = path;
+    flight.budget_ms = budget_ms;
+    flight.enabled = true;
+
+    tui_get_stats(&flight.last_stats);
+    flight.last_color_misses = draw_get_color_misses();
+}
+
+void flight_begin_frame(void)
+{
+    if (!flight.enabled)
+        return;
+
+    flight.frame_start = flight.last_mark = state_get_time_ms();
+    for (int i = 0; i < FLIGHT_PHASES; i++)
+        flight.phase_ms[i] = 0.0f;
+}
+
+/* Charge the time since the previous mark to a phase */
+void flight_mark(flight_phase_t phase)
+{
+    if (!flight.enabled)
+        return;
+
+    double now = state_get_time_ms();
+    flight.phase_ms[phase] += now - flight.last_mark;
+    flight.last_mark = now;
+}
+
+static void flight_dump(const flight_frame_t *slow)
+{
+    FILE *out = fopen(flight.path, "a");
+    if (!out)
+        return;
+
+    fprintf(out, "# slow frame %llu: %.2f ms, budget %.2f ms\n",
+            (unsigned long long) slow->seq, slow->total_ms, flight.budget_ms);
+    fprintf(out, "#%7s %7s", "frame", "total");
+    for (int i = 0; i < FLIGHT_PHASES; i++)
+        fprintf(out, " %7s", phase_names[i]);
+    fprintf(out, " %6s %7s %6s %5s %4s %4s %5s\n", "writes", "bytes", "dirty",
+            "objs", "esc", "pair", "color");
+
+    uint64_t first =
+        flight.seq > FLIGHT_FRAMES ? flight.seq - FLIGHT_FRAMES : 0;
+    for (uint64_t seq = first; seq < flight.seq; seq++) {
+        const flight_frame_t *f = &flight.frames[seq % FLIGHT_FRAMES];
+
+        fprintf(out, "%7llu%c %7.2f", (unsigned long long) f->seq,
+                f == slow ? '*' : ' ', f->total_ms);
+        for (int i = 0; i < FLIGHT_PHASES; i++)
+            fprintf(out, " %7.2f", f->phase_ms[i]);
+        fprintf(out, " %6u %7u %6u %5u %4u %4u %5u\n", f->writes, f->bytes,
+                f->dirty_cells, f->objects, f->esc_misses, f->pair_misses,
+                f->color_misses);
+    }
+    fputc('\n', out);
+    fclose(out);
+}
+
+/**
+ * Record the statistics of the frame that just finished
+ * @objects : Live game objects during the frame
+ */
+void flight_end_frame(int objects)
+{
+    if (!flight.enabled)
+        return;
+
+    tui_stats_t stats;
+    tui_get_stats(&stats);
+    uint64_t color_misses = draw_get_color_misses();
+
+    flight_frame_t *f = &flight.frames[flight.seq % FLIGHT_FRAMES];
+    f->seq = flight.seq;
+    f->total_ms = state_get_time_ms() - flight.frame_start;
+    for (int i = 0; i < FLIGHT_PHASES; i++)
+        f->phase_ms[i] = flight.phase_ms[i];
+    f->writes = stats.writes - flight.last_stats.writes;
+    f->bytes = stats.bytes - flight.last_stats.bytes;
+    f->dirty_cells = stats.dirty_cells - flight.last_stats.dirty_cells;
+    f->objects = objects;
+    f->esc_misses = stats.esc_misses - flight.last_stats.esc_misses;
+    f->pair_misses = stats.pair_misses - flight.last_stats.pair_misses;
+    f->color_misses = color_misses - flight.last_color_misses;
+
+    flight.last_stats = stats;
+    flight.last_color_misses = color_misses;
+    flight.seq++;
+
+    if (f->total_ms > flight.budget_ms && f->seq >= flight.next_dump) {
+        flight_dump(f);
+        flight.next_dump = flight.seq + FLIGHT_FRAMES;
+    }
+}
@@ -0,0 +1,321 @@
+/*
+ * Split-screen multi-world view
+ *
+ * Runs several independent worlds, each driven by the autoplayer, and
+ * composes them into a grid of sub-windows of one terminal. Every frame the
+ * worlds are updated and drawn in parallel by a small worker pool: each tile
+ * is drawn into its own deferred window, so workers never touch shared TUI
+ * state. The main thread then publishes the dirty rows of all tiles and does
+ * a single diff and flush for the combined screen.
+ */
+
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "probe.h"
+#include "trex.h"
+
+#define GRID_MAX_WORLDS 64
+#define GRID_RESTART_MS 2000.0 /* How long a dead world stays on screen */
+
+typedef struct {
+    world_t *world;
+    tui_window_t *win;
+    double dead_since; /* Time the player died, 0 while alive */
+} grid_tile_t;
+
+static struct {
+    grid_tile_t tiles[GRID_MAX_WORLDS];
+    int count;
+
+    /* Worker pool, the main thread takes part in every frame */
+    pthread_t threads[GRID_MAX_WORLDS];
+    int nworkers;
+    pthread_mutex_t lock;
+    pthread_cond_t wake, idle;
+    unsigned int frame_seq; /* Bumped to start a frame */
+    int busy;               /* Workers still composing the current frame */
+    int next_tile;          /* Next tile to claim in the current frame */
+    int64_t step_ns; /* World time covered by the current frame */
+    double now;
+    bool quit;
+
+    bool relayout; /* Terminal size changed */
+} grid = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER,
+};
+
+/* Split the screen into tiles and fit every world to its tile */
+static void grid_layout(void)
+{
+    int lines = tui_get_max_y(tui_stdscr);
+    int cols = tui_get_max_x(tui_stdscr);
+
+    int grid_cols = 1;
+    while (grid_cols * grid_cols < grid.count)
+        grid_cols++;
+    int grid_rows = (grid.count + grid_cols - 1) / grid_cols;
+
+    /* One blank column separates neighboring tiles */
+    int tile_w = (cols - (grid_cols - 1)) / grid_cols;
+    int tile_h = lines / grid_rows;
+    if (tile_w < 1)
+        tile_w = 1;
+    if (tile_h < 1)
+        tile_h = 1;
+
+    for (int i = 0; i < grid.count; i++) {
+        grid_tile_t *tile = &grid.tiles[i];
+        int y = (i / grid_cols) * tile_h;
+        int x = (i % grid_cols) * (tile_w + 1);
+
+        tui_delwin(tile->win);
+        tile->win = tui_newwin(tile_h, tile_w, y, x);
+        play_world_resize(tile->world, tile_h, tile_w);
+    }
+
+    tui_clear_window(tui_stdscr);
+}
+
+static void grid_on_resize(void)
+{
+    grid.relayout = true;
+}
+
+/* Advance one world by a frame and draw it into its window */
+static void grid_step_tile(int index)
+{
+    grid_tile_t *tile = &grid.tiles[index];
+    world_t *w = tile->world;
+
+    TRACE_BEGIN("tile");
+
+    int key = play_world_bot_input(w);
+    if (key != -1)
+        play_world_handle_input(w, key);
+
+    play_world_update(w, grid.step_ns);
+
+    /* Restart dead worlds after showing their final score for a while */
+    if (play_world_is_dead(w)) {
+        if (tile->dead_since == 0.0) {
+            tile->dead_since = grid.now;
+        } else if (grid.now - tile->dead_since > GRID_RESTART_MS) {
+            play_world_reset(w);
+            tile->dead_since = 0.0;
+        }
+    }
+
+    if (tile->win) {
+        draw_set_target(tile->win);
+        tui_clear_window(tile->win);
+        play_world_render(w);
+
+        char label[16];
+        snprintf(label, sizeof(label), "#%d", index + 1);
+        draw_text(1, 0, label, TUI_COLOR_PAIR(2));
+        draw_set_target(NULL);
+    }
+
+    TRACE_END("tile");
+}
+
+/* Claim and process tiles until none are left in this frame */
+static void grid_compose(void)
+{
+    int index;
+    while ((index = __atomic_fetch_add(&grid.next_tile, 1,
+                                       __ATOMIC_RELAXED)) < grid.count)
+        grid_step_tile(index);
+}
+
+static void *grid_worker(void *arg)
+{
+    (void) arg;
+    unsigned int seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&grid.lock);
+        while (grid.frame_seq == seen && !grid.quit)
+            pthread_cond_wait(&grid.wake, &grid.lock);
+        seen = grid.frame_seq;
+        bool quit = grid.quit;
+        pthread_mutex_unlock(&grid.lock);
+
+        if (quit)
+            break;
+
+        grid_compose();
+
+        pthread_mutex_lock(&grid.lock);
+        if (--grid.busy == 0)
+            pthread_cond_signal(&grid.idle);
+        pthread_mutex_unlock(&grid.lock);
+    }
+
+    return NULL;
+}
+
+static void grid_render_frame(int64_t step_ns)
+{
+    grid.step_ns = step_ns;
+    grid.now = state_get_time_ms();
+    grid.next_tile = 0;
+
+    TRACE_BEGIN("frame");
+    PROBE(frame_begin);
+
+    /* Update and draw all tiles in parallel */
+    pthread_mutex_lock(&grid.lock);
+    grid.busy = grid.nworkers;
+    grid.frame_seq++;
+    pthread_cond_broadcast(&grid.wake);
+    pthread_mutex_unlock(&grid.lock);
+
+    grid_compose();
+
+    pthread_mutex_lock(&grid.lock);
+    while (grid.busy > 0)
+        pthread_cond_wait(&grid.idle, &grid.lock);
+    pthread_mutex_unlock(&grid.lock);
+
+    /* One diff and flush for the whole screen */
+    for (int i = 0; i < grid.count; i++)
+        tui_wnoutrefresh(grid.tiles[i].win);
+    tui_refresh(tui_stdscr);
+
+    PROBE1(frame_end, grid.frame_seq);
+    TRACE_END("frame");
+}
+
+/* Live objects of all worlds, and the best level and score among them */
+static void grid_publish_stats(void)
+{
+    int objects = 0, level = 0, score = 0;
+
+    for (int i = 0; i < grid.count; i++) {
+        const world_t *w = grid.tiles[i].world;
+        objects += play_world_object_count(w);
+        if (play_world_level(w) > level)
+            level = play_world_level(w);
+        if (play_world_score(w) > score)
+            score = play_world_score(w);
+    }
+    stats_end_frame(objects, level, score);
+}
+
+/* One worker per CPU, the main thread counts as one of them */
+static void grid_start_workers(void)
+{
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int wanted = (ncpu > grid.count) ? grid.count : (int) ncpu;
+
+    grid.quit = false;
+    grid.nworkers = 0;
+    for (int i = 1; i < wanted; i++) {
+        /* Run with the workers we got */
+        if (pthread_create(&grid.threads[grid.nworkers], NULL, grid_worker,
+                           NULL))
+            break;
+        grid.nworkers++;
+    }
+}
+
+static void grid_stop_workers(void)
+{
+    pthread_mutex_lock(&grid.lock);
+    grid.quit = true;
+    pthread_cond_broadcast(&grid.wake);
+    pthread_mutex_unlock(&grid.lock);
+
+    for (int i = 0; i < grid.nworkers; i++)
+        pthread_join(grid.threads[i], NULL);
+    grid.nworkers = 0;
+}
+
+int grid_run(int count)
+{
+    const game_config_t *cfg = ensure_cfg();
+
+    if (count < 1)
+        count = 1;
+    if (count > GRID_MAX_WORLDS)
+        count = GRID_MAX_WORLDS;
+
+    unsigned int seed = time(NULL);
+    for (int i = 0; i < count; i++) {
+        grid.tiles[i].world = play_world_new(tui_get_max_y(tui_stdscr),
+                                             tui_get_max_x(tui_stdscr),
+                                             seed + i * 7919);
+        if (!grid.tiles[i].world)
+            break;
+        grid.count++;
+    }
+    if (!grid.count)
+        return 1;
+
+    /* Same color pairs as the interactive game */
+    tui_init_pair(1, TUI_COLOR_GREEN, TUI_COLOR_BLACK);
+    tui_init_pair(2, TUI_COLOR_CYAN, TUI_COLOR_BLACK);
+    draw_init_buffers();
+
+    grid_layout();
+    tui_set_resize_hook(grid_on_resize);
+
+    grid_start_workers();
+
+    double last_frame_time = state_get_time_ms();
+    double last_update_time = last_frame_time;
+    double accumulator = 0.0;
+
+    for (;;) {
+        tui_check_shutdown();
+        tui_check_resize();
+        if (grid.relayout) {
+            grid.relayout = false;
+            grid_layout();
+        }
+
+        double current_time = state_get_time_ms();
+        accumulator += current_time - last_frame_time;
+        last_frame_time = current_time;
+
+        if (accumulator < cfg->timing.frame_time) {
+            struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+            poll(&pfd, 1, 4);
+            continue;
+        }
+
+        bool quit = false;
+        int max_inputs = 8;
+        while (max_inputs-- > 0 && tui_has_input()) {
+            int ch = tui_getch();
+            if (ch == 'q' || ch == 'Q' || ch == TUI_KEY_ESC)
+                quit = true;
+        }
+        if (quit)
+            break;
+
+        stats_begin_frame();
+        grid_render_frame((current_time - last_update_time) * NS_PER_MS);
+        grid_publish_stats();
+        alloc_guard_frame();
+        last_update_time = current_time;
+        accumulator -= cfg->timing.frame_time;
+    }
+
+    grid_stop_workers();
+
+    for (int i = 0; i < grid.count; i++) {
+        tui_delwin(grid.tiles[i].win);
+        play_world_free(grid.tiles[i].world);
+    }
+    grid.count = 0;
+
+    return 0;
+}
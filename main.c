@@ -1,18 +1,283 @@
+#include <limits.h>
+#include <malloc.h>
 #include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#include "probe.h"
 #include "trex.h"
 
-int main()
+static void usage(const char *prog)
 {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --serve-binary  Stream binary cell diffs on stdout for "
+            "trex-view\n"
+            "  --grid N        Watch N autoplayed worlds side by side\n"
+            "  --bench N       Time N headless frames with perf counters\n"
+            "  --scene RxC:S   Bench screen size and world seed "
+            "(default: 50x160:1)\n"
+            "  --soak M        Play M headless minutes, fail on upward "
+            "trends\n"
+            "  --trace FILE    Write a Chrome trace of frame phases at exit\n"
+            "  --profile FILE  Sample CPU time, write folded stacks at exit\n"
+#ifdef ALLOC_GUARD
+            "  --alloc-guard N Abort on any heap allocation after N frames\n"
+#endif
+            "  --lean          Small renderer caches, report memory at exit\n"
+            "  --idle SECONDS  Release the renderer after SECONDS without "
+            "input\n"
+            "  --flight FILE   Append the last 256 frames to FILE when one is "
+            "slow\n"
+            "  --budget MS     Slow frame threshold (default: 2x frame time)\n"
+            "  --stats         Publish live counters for trex-top\n"
+            "  --scores FILE   High-score table shared by all sessions "
+            "(default: ~/.trex-scores)\n"
+            "  -h, --help      Show this help\n",
+            prog);
+}
+
+/* Refresh game state after the TUI buffers were resized */
+static void on_terminal_resize(void)
+{
+    /* Notify the drawing system to refresh everything */
+    draw_clear_back_buffer();
+
+    /* Adjust game object positions for new screen size */
+    play_adjust_for_resize();
+}
+
+/* Write out diagnostics before a fatal signal is re-raised */
+static void on_shutdown_signal(void)
+{
+    alloc_guard_disarm();
+    trace_close();
+    profile_close();
+    stats_close();
+}
+
+/* Per-session memory, printed once the terminal is restored */
+static void report_footprint(const tui_footprint_t *fp)
+{
+    fprintf(stderr,
+            "footprint: %zu bytes renderer (screen %zu, cursor %zu, "
+            "dirty %zu, escapes %zu, output %zu, fixed %zu)\n",
+            fp->total, fp->screen, fp->cursor, fp->dirty, fp->escapes,
+            fp->output, fp->fixed);
+    if (fp->rss_kb)
+        fprintf(stderr,
+                "footprint: %zu KiB private, %zu KiB resident, %zu KiB "
+                "peak\n",
+                fp->anon_kb, fp->rss_kb, fp->peak_rss_kb);
+}
+
+/* Idle sessions, see hibernate() */
+static struct {
+    int sleeps;
+    size_t heap, anon_kb; /* Measured during the last sleep */
+} idle;
+
+/**
+ * Sleep until the next key with only the world state kept in memory
+ *
+ * The renderer drops its screen buffers and caches, the drawing layer its
+ * color registry and the world its spatial index. Everything is reserved
+ * again before the key is handled, and the first frame after waking repaints
+ * the whole screen.
+ */
+static void hibernate(void)
+{
+    play_hibernate();
+    draw_hibernate();
+    tui_hibernate();
+
+    tui_footprint_t fp;
+    tui_get_footprint(&fp);
+    idle.sleeps++;
+    idle.heap = mallinfo2().uordblks;
+    idle.anon_kb = fp.anon_kb;
+
+    tui_wait_event();
+
+    if (!tui_wake()) {
+        fprintf(stderr, "Failed to reallocate buffers after idling\n");
+        state_quit_game();
+    }
+    draw_wake();
+    play_wake();
+}
+
+static void report_idle(void)
+{
+    fprintf(stderr,
+            "idle: slept %d times, %zu bytes heap and %zu KiB private while "
+            "asleep\n",
+            idle.sleeps, idle.heap, idle.anon_kb);
+}
+
+/**
+ * Release rendering resources and restore the terminal
+ * @report : Print the renderer footprint afterwards
+ */
+static void finalize(bool report)
+{
+    tui_footprint_t fp;
+
+    /* Teardown is not part of the steady state */
+    alloc_guard_disarm();
+    stats_close();
+    sched_close();
+    board_close();
+
+    /* Measure before anything is released */
+    if (report)
+        tui_get_footprint(&fp);
+
+    /* Cleanup render buffers and colors */
+    draw_cleanup_buffers();
+    draw_cleanup_colors();
+
+    /* Finalize TUI */
+    tui_noraw();
+    tui_set_cursor(1);
+    tui_echo();
+    tui_clear_screen();
+    tui_cleanup();
+
+    if (report)
+        report_footprint(&fp);
+    if (idle.sleeps)
+        report_idle();
+}
+
+int main(int argc, char *argv[])
+{
+    int grid_worlds = 0;
+    int bench_frames = 0;
+    int soak_minutes = 0;
+    bool lean = false;
+    double idle_ms = 0.0;
+    const char *flight_path = NULL;
+    double flight_budget = 0.0;
+    bool publish_stats = false;
+    const char *scores_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--serve-binary")) {
+            tui_set_backend(TUI_BACKEND_WIRE);
+        } else if (!strcmp(argv[i], "--grid") && i + 1 < argc) {
+            grid_worlds = atoi(argv[++i]);
+            if (grid_worlds < 1) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--bench") && i + 1 < argc) {
+            bench_frames = atoi(argv[++i]);
+            if (bench_frames < 1) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--soak") && i + 1 < argc) {
+            soak_minutes = atoi(argv[++i]);
+            if (soak_minutes < 1) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--scene") && i + 1 < argc) {
+            int rows, cols;
+            unsigned int seed = 1;
+            if (sscanf(argv[++i], "%dx%d:%u", &rows, &cols, &seed) < 2 ||
+                rows < 3 || cols < 10) {
+                usage(argv[0]);
+                return 1;
+            }
+            bench_set_scene(rows, cols, seed);
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            trace_open(argv[++i]);
+#ifdef ALLOC_GUARD
+        } else if (!strcmp(argv[i], "--alloc-guard") && i + 1 < argc) {
+            int frames = atoi(argv[++i]);
+            if (frames < 1) {
+                usage(argv[0]);
+                return 1;
+            }
+            alloc_guard_arm_after(frames);
+#endif
+        } else if (!strcmp(argv[i], "--lean")) {
+            lean = true;
+            tui_set_lean(true);
+        } else if (!strcmp(argv[i], "--idle") && i + 1 < argc) {
+            idle_ms = atof(argv[++i]) * 1000.0;
+            if (idle_ms <= 0.0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--profile") && i + 1 < argc) {
+            if (!profile_open(argv[++i])) {
+                perror("profile");
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--flight") && i + 1 < argc) {
+            flight_path = argv[++i];
+        } else if (!strcmp(argv[i], "--budget") && i + 1 < argc) {
+            flight_budget = atof(argv[++i]);
+            if (flight_budget <= 0.0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--stats")) {
+            publish_stats = true;
+        } else if (!strcmp(argv[i], "--scores") && i + 1 < argc) {
+            scores_path = argv[++i];
+        } else if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
+            usage(argv[0]);
+            return 0;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
     /* Get configuration */
     const game_config_t *cfg = ensure_cfg();
 
     /* Initialize sprites */
     sprites_init();
 
+    tui_set_shutdown_hook(on_shutdown_signal);
+
+    /* The benchmark and the soak test set up their own headless screen */
+    if (bench_frames)
+        return bench_run(bench_frames);
+    if (soak_minutes)
+        return bench_soak(soak_minutes);
+
+    if (publish_stats && !stats_open(grid_worlds ? "grid" : "play"))
+        perror("stats");
+
+    /* Autoplayed grid worlds stay off the high-score table */
+    if (!grid_worlds) {
+        char home_scores[PATH_MAX];
+        const char *home = getenv("HOME");
+        if (scores_path) {
+            if (!board_open(scores_path))
+                perror("scores");
+        } else if (home) {
+            snprintf(home_scores, sizeof(home_scores), "%s/.trex-scores",
+                     home);
+            board_open(home_scores);
+        }
+    }
+
     /* Initialize TUI */
-    tui_init();
+    if (!tui_init()) {
+        stats_close();
+        fprintf(stderr, "Failed to initialize terminal\n");
+        return 1;
+    }
+    tui_set_resize_hook(on_terminal_resize);
     tui_raw();
     tui_set_nodelay(tui_stdscr, true);
     tui_set_keypad(tui_stdscr, true);
@@ -21,11 +286,29 @@ int main()
     tui_start_color();
     tui_cbreak();
 
+    /* Split-screen view replaces the interactive game */
+    if (grid_worlds) {
+        int ret = grid_run(grid_worlds);
+        finalize(lean);
+        return ret;
+    }
+
     /* Initialize the game */
     state_initialize();
 
+    if (flight_path)
+        flight_open(flight_path, flight_budget > 0.0
+                                     ? flight_budget
+                                     : 2.0 * cfg->timing.frame_time);
+
+    /* Every tick is simulated, renders are dropped when the CPU is short */
+    sched_open(cfg->timing.frame_time);
+    int64_t step_ns = cfg->timing.frame_time * NS_PER_MS;
+
     double last_frame_time = state_get_time_ms();
+    double last_input_time = last_frame_time;
     double accumulator = 0.0;
+    uint64_t frames = 0;
 
     /* While the game is active */
     while (state_is_running()) {
@@ -45,23 +328,56 @@ int main()
 
         /* Only update and render at target frame rate */
         if (accumulator >= cfg->timing.frame_time) {
+            bool render = sched_begin_tick(&accumulator);
+            TRACE_BEGIN("frame");
+            PROBE(frame_begin);
+            flight_begin_frame();
+            stats_begin_frame();
+
             /* Process all available input events to reduce latency.
              * This prevents input lag when multiple keys are pressed quickly
              */
+            TRACE_BEGIN("input");
             int max_inputs = 8; /* Process up to 8 inputs per frame */
             while (max_inputs-- > 0 && tui_has_input()) {
                 int ch = tui_getch();
-                if (ch != -1)
+                if (ch != -1) {
                     state_handle_input(ch);
+                    last_input_time = current_time;
+                }
             }
+            TRACE_END("input");
+            flight_mark(FLIGHT_INPUT);
 
             /* Update the game */
-            state_update_frame();
+            TRACE_BEGIN("update");
+            state_update_frame(step_ns);
+            TRACE_END("update");
+            flight_mark(FLIGHT_UPDATE);
+
+            /* Render the game, unless the scheduler skips this tick */
+            double updated_time = state_get_time_ms();
+            if (render)
+                state_render_frame();
+            double rendered_time = state_get_time_ms();
 
-            /* Render the game */
-            state_render_frame();
+            PROBE1(frame_end, frames);
+            frames++;
+            TRACE_END("frame");
+            flight_end_frame(play_object_count());
+            stats_end_frame(play_object_count(), play_level(), play_score());
+            alloc_guard_frame();
+            sched_end_tick(updated_time - current_time,
+                           render ? rendered_time - updated_time : 0.0);
 
             accumulator -= cfg->timing.frame_time;
+        } else if (idle_ms > 0.0 && current_time - last_input_time >= idle_ms &&
+                   state_is_quiescent()) {
+            hibernate();
+
+            /* Handle the wake-up key in the very next frame */
+            last_frame_time = last_input_time = state_get_time_ms();
+            accumulator = cfg->timing.frame_time;
         } else {
             /* Use poll() with 4ms timeout for low-latency input polling.
              * This matches the optimized tui_getch() implementation
@@ -73,16 +389,7 @@ int main()
         }
     }
 
-    /* Cleanup render buffers and colors */
-    draw_cleanup_buffers();
-    draw_cleanup_colors();
-
-    /* Finalize TUI */
-    tui_noraw();
-    tui_set_cursor(1);
-    tui_echo();
-    tui_clear_screen();
-    tui_cleanup();
+    finalize(lean);
 
     return 0;
 }
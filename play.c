@@ -1,9 +1,11 @@
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 #include "private.h"
+#include "probe.h"
 #include "trex.h"
 
 /* Ring buffer for fixed-size, cache-friendly object management.
@@ -35,22 +37,39 @@ static inline bool object_is_invalid(const object_t *obj)
 }
 
 /* Forward declarations for spatial collision system */
-static void collect_powerup(object_t *powerup);
+static void collect_powerup(world_t *w, object_t *powerup);
 
 /* Helper functions for collision detection */
 static bool involves_ground_hole(object_t const *obj1, object_t const *obj2);
-static bool is_player_enemy(object_t const *obj1, object_t const *obj2);
-static bool is_player_powerup(object_t const *obj1, object_t const *obj2);
+static bool is_player_enemy(const world_t *w,
+                            object_t const *obj1,
+                            object_t const *obj2);
+static bool is_player_powerup(const world_t *w,
+                              object_t const *obj1,
+                              object_t const *obj2);
 
 /* Spatial collision detection helpers */
 typedef struct {
     int left, right, top, bottom;
 } bounding_rect_t;
 
-static bounding_rect_t get_bounds(const object_t *obj, bool is_player);
+static bounding_rect_t get_bounds(const world_t *w,
+                                  const object_t *obj,
+                                  bool is_player);
+static void sweep_bounds(const world_t *w,
+                         const object_t *obj,
+                         bounding_rect_t *bounds);
 static bool bounds_overlap(const bounding_rect_t *rect1,
                            const bounding_rect_t *rect2);
 
+/* Spawns planned ahead of time, see spawn_plan_fill() */
+#define SPAWN_LOOKAHEAD 8
+
+typedef struct {
+    object_type_t type;
+    float delay; /* Milliseconds after the previous spawn */
+} spawn_slot_t;
+
 /* Values used to initialize objects */
 #define HEIGHT_ZERO 0
 
@@ -65,32 +84,16 @@ static bool bounds_overlap(const bounding_rect_t *rect1,
 /* Fast fall mechanics */
 #define FAST_FALL_MULTIPLIER 2.5
 
+/* Sprites grow by one step for every SCALE_ROWS rows above the score and
+ * ground bands and SCALE_COLS columns, so a jump and the run-up to the next
+ * obstacle keep their share of the screen.
+ */
+#define SCALE_BANDS 10
+#define SCALE_ROWS 30
+#define SCALE_COLS 80
+
 /* Off-screen position for removed objects */
-#define OFFSCREEN_X (RESOLUTION_COLS + 1)
-
-/* Game state variables */
-static int user_score = 0, distance = 0, current_level = 0;
-static float powerup_time = -1, obstacle_time = -1;
-static bool is_dead = false, is_falling_animation = false,
-            can_throw_fireball = true;
-static object_type_t powerup_type;
-static double last_key_check_time = 0.0;
-static object_t player;
-
-/* Streak counter for consecutive aerial obstacle clears */
-static int aerial_streak = 0;
-static int max_streak = 0;
-static bool was_airborne_last_frame = false;
-static bool cleared_obstacle_while_airborne = false;
-
-/* Jump buffer and coyote time state */
-static double last_jump_keydown = 0.0;
-static double left_ground_at = 0.0;
-
-/* Fast-fall state */
-static bool is_fast_falling = false;
-static double fast_fall_multiplier = FAST_FALL_MULTIPLIER;
-static double last_fast_fall_time = 0.0;
+#define OFFSCREEN_X (w->cols + 1)
 
 /*
  * Spatial collision detection optimization system
@@ -118,7 +121,68 @@ typedef struct {
     int next_free_node;        /* Next available node in pool */
 } spatial_hash_t;
 
-static spatial_hash_t spatial_hash;
+/*
+ * Game world
+ *
+ * Everything a running game needs lives here, so several worlds can be
+ * simulated side by side (see grid.c). Worlds never touch each other and
+ * only read the shared configuration, so distinct worlds may be updated and
+ * rendered from different threads concurrently.
+ */
+struct world {
+    int rows, cols;    /* Surface size the world is laid out for */
+    int scale;         /* Sprite size, physics and hitboxes in 1..3 */
+    unsigned int seed; /* Per-world random state for rand_r() */
+
+    /*
+     * World clock in nanoseconds, advanced once per step by the time that
+     * step covers. Input and timeouts are stamped with it, so every read
+     * within a step agrees and a headless run can feed it virtual time.
+     */
+    int64_t clock_ns;
+
+    /* Game state variables */
+    int user_score, distance, current_level;
+    float powerup_time;
+    bool is_dead, is_falling_animation, can_throw_fireball;
+    object_type_t powerup_type;
+    int64_t last_key_check_time;
+    object_t player;
+
+    /* Streak counter for consecutive aerial obstacle clears */
+    int aerial_streak;
+    int max_streak;
+    bool was_airborne_last_frame;
+    bool cleared_obstacle_while_airborne;
+
+    /* Jump buffer and coyote time state */
+    int64_t last_jump_keydown;
+    int64_t left_ground_at;
+
+    /* Fast-fall state */
+    bool is_fast_falling;
+    double fast_fall_multiplier;
+    int64_t last_fast_fall_time;
+
+    /* Sub-cell scroll position and the whole cells moved in this update */
+    int scroll_frac, scroll_step;
+
+    /* Update timers */
+    double f_time_10ms;
+    double f_time_150ms;
+    double f_time_random;
+
+    /* Upcoming spawns, the head is due when f_time_random reaches its delay */
+    spawn_slot_t spawns[SPAWN_LOOKAHEAD];
+    int spawn_head, spawn_count;
+
+    /* Ring buffer to store game objects - fixed-size, no dynamic allocation */
+    object_ring_buffer_t objects;
+    spatial_hash_t spatial;
+};
+
+/* World driven by the interactive state machine */
+static world_t main_world;
 
 /* Ring buffer operations: O(1) push/pop with fixed memory footprint */
 
@@ -176,7 +240,7 @@ static void ring_buffer_cleanup_invalid(object_ring_buffer_t *rb)
  *
  * Return bucket index for spatial hash, clamped to valid range
  */
-static inline int spatial_get_bucket(int x)
+static inline int spatial_get_bucket(const world_t *w, int x)
 {
     const game_config_t *cfg = ensure_cfg();
 
@@ -186,33 +250,52 @@ static inline int spatial_get_bucket(int x)
 
     /* Calculate bucket index and clamp to maximum */
     int bucket = x / cfg->spatial.bucket_size;
-    return (bucket >= spatial_hash.bucket_count) ? spatial_hash.bucket_count - 1
-                                                 : bucket;
+    return (bucket >= w->spatial.bucket_count) ? w->spatial.bucket_count - 1
+                                               : bucket;
 }
 
 /**
- * Clear spatial hash (called each frame)
+ * Allocate spatial hash storage when the world is created
  *
- * Reset all buckets and node pool for next frame
+ * Frames only reuse it, so collision detection never allocates
  */
-static void spatial_clear(void)
+static void spatial_init(world_t *w)
 {
     const game_config_t *cfg = ensure_cfg();
 
-    /* Initialize buckets on first use if needed */
-    if (!spatial_hash.buckets) {
-        spatial_hash.bucket_count = cfg->spatial.bucket_count;
-        spatial_hash.buckets =
-            calloc(spatial_hash.bucket_count, sizeof(spatial_node_t *));
-        spatial_hash.node_pool =
-            calloc(cfg->limits.max_objects, sizeof(spatial_node_t));
-        spatial_hash.max_objects = cfg->limits.max_objects;
-    }
+    w->spatial.bucket_count = cfg->spatial.bucket_count;
+    w->spatial.buckets =
+        calloc(w->spatial.bucket_count, sizeof(spatial_node_t *));
+    w->spatial.node_pool =
+        calloc(cfg->limits.max_objects, sizeof(spatial_node_t));
+    w->spatial.max_objects = cfg->limits.max_objects;
+}
+
+static void spatial_free(world_t *w)
+{
+    free(w->spatial.buckets);
+    free(w->spatial.node_pool);
+    w->spatial.buckets = NULL;
+    w->spatial.node_pool = NULL;
+    w->spatial.bucket_count = 0;
+    w->spatial.max_objects = 0;
+}
+
+/**
+ * Clear spatial hash (called each frame)
+ *
+ * Reset all buckets and node pool for next frame
+ */
+static void spatial_clear(world_t *w)
+{
+    /* Storage could not be allocated, collisions fall back to none */
+    if (!w->spatial.buckets)
+        return;
 
     /* Clear spatial hash - use memset for efficiency */
-    memset(spatial_hash.buckets, 0,
-           spatial_hash.bucket_count * sizeof(spatial_node_t *));
-    spatial_hash.next_free_node = 0;
+    memset(w->spatial.buckets, 0,
+           w->spatial.bucket_count * sizeof(spatial_node_t *));
+    w->spatial.next_free_node = 0;
 }
 
 /**
@@ -221,37 +304,36 @@ static void spatial_clear(void)
  *
  * Objects are bucketed by X coordinate for faster collision queries
  */
-static void spatial_add_object(object_t *object)
+static void spatial_add_object(world_t *w, object_t *object)
 {
     const game_config_t *cfg = ensure_cfg();
 
     /* Early validation checks */
-    if (!object || !spatial_hash.buckets || !spatial_hash.node_pool)
+    if (!object || !w->spatial.buckets || !w->spatial.node_pool)
         return;
 
     /* Skip objects that are completely off-screen to reduce collision workload
      */
     int bounds_buffer = cfg->physics.bounds_buffer;
     if (object->x + object->cols < -bounds_buffer ||
-        object->x > RESOLUTION_COLS + bounds_buffer)
+        object->x > w->cols + bounds_buffer)
         return;
 
     /* Prevent node pool overflow */
-    if (spatial_hash.next_free_node >= spatial_hash.max_objects)
+    if (w->spatial.next_free_node >= w->spatial.max_objects)
         return;
 
-    int bucket_idx = spatial_get_bucket(object->x);
+    int bucket_idx = spatial_get_bucket(w, object->x);
 
     /* Defensive bounds check */
-    if (bucket_idx < 0 || bucket_idx >= spatial_hash.bucket_count)
+    if (bucket_idx < 0 || bucket_idx >= w->spatial.bucket_count)
         return;
 
     /* Allocate node from pool and link to bucket */
-    spatial_node_t *node =
-        &spatial_hash.node_pool[spatial_hash.next_free_node++];
+    spatial_node_t *node = &w->spatial.node_pool[w->spatial.next_free_node++];
     node->object = object;
-    node->next = spatial_hash.buckets[bucket_idx];
-    spatial_hash.buckets[bucket_idx] = node;
+    node->next = w->spatial.buckets[bucket_idx];
+    w->spatial.buckets[bucket_idx] = node;
 }
 
 /**
@@ -260,22 +342,22 @@ static void spatial_add_object(object_t *object)
  *
  * Return closest targetable object or NULL if none found
  */
-static object_t *find_closest_target(object_t const *fireball)
+static object_t *find_closest_target(const world_t *w, object_t const *fireball)
 {
-    if (!fireball || !spatial_hash.buckets)
+    if (!fireball || !w->spatial.buckets)
         return NULL;
 
     object_t *closest = NULL;
-    int min_distance = RESOLUTION_COLS;
+    int min_distance = w->cols;
 
     /* Check current bucket and adjacent buckets */
-    int fireball_bucket = spatial_get_bucket(fireball->x);
+    int fireball_bucket = spatial_get_bucket(w, fireball->x);
     for (int bucket_offset = -1; bucket_offset <= 1; bucket_offset++) {
         int bucket_idx = fireball_bucket + bucket_offset;
-        if (bucket_idx < 0 || bucket_idx >= spatial_hash.bucket_count)
+        if (bucket_idx < 0 || bucket_idx >= w->spatial.bucket_count)
             continue;
 
-        for (spatial_node_t *node = spatial_hash.buckets[bucket_idx];
+        for (spatial_node_t *node = w->spatial.buckets[bucket_idx];
              node != NULL; node = node->next) {
             object_t *obj = node->object;
             if (obj && obj->x < min_distance &&
@@ -297,7 +379,9 @@ static object_t *find_closest_target(object_t const *fireball)
  *
  * Check for overlap and handle collision effects if detected
  */
-static void spatial_collision_check_pair(object_t *obj1, object_t *obj2)
+static void spatial_collision_check_pair(world_t *w,
+                                         object_t *obj1,
+                                         object_t *obj2)
 {
     const game_config_t *cfg = ensure_cfg();
     if (obj1 == obj2)
@@ -306,16 +390,19 @@ static void spatial_collision_check_pair(object_t *obj1, object_t *obj2)
     /* Get bounding rectangles for collision detection */
     bool has_ground_hole = involves_ground_hole(obj1, obj2);
     bool player_duck_adjust =
-        !has_ground_hole && ((obj1 == &player) || (obj2 == &player));
+        !has_ground_hole && ((obj1 == &w->player) || (obj2 == &w->player));
 
     bounding_rect_t bounds1 =
-        get_bounds(obj1, player_duck_adjust && obj1 == &player);
+        get_bounds(w, obj1, player_duck_adjust && obj1 == &w->player);
     bounding_rect_t bounds2 =
-        get_bounds(obj2, player_duck_adjust && obj2 == &player);
+        get_bounds(w, obj2, player_duck_adjust && obj2 == &w->player);
+    sweep_bounds(w, obj1, &bounds1);
+    sweep_bounds(w, obj2, &bounds2);
 
     /* Check for collision */
     if (!bounds_overlap(&bounds1, &bounds2))
         return; /* No collision detected */
+    PROBE3(collision, obj1->type, obj2->type, obj1->x);
 
     /* Handle collision effects based on object types */
 
@@ -327,30 +414,30 @@ static void spatial_collision_check_pair(object_t *obj1, object_t *obj2)
 
     if (is_fireball_collision) {
         obj1->x = obj2->x = OFFSCREEN_X;
-        user_score += cfg->scoring.fireball_kill;
+        w->user_score += cfg->scoring.fireball_kill;
         return;
     }
 
     /* Player vs enemy collisions */
-    if (is_player_enemy(obj1, obj2)) {
-        object_t const *enemy = (obj1 == &player) ? obj2 : obj1;
+    if (is_player_enemy(w, obj1, obj2)) {
+        object_t const *enemy = (obj1 == &w->player) ? obj2 : obj1;
 
         if (enemy->type == OBJECT_GROUND_HOLE) {
-            player.state = STATE_FALLING;
-            is_falling_animation = true;
-        } else if (powerup_time > 0.0f &&
-                   powerup_type == OBJECT_EGG_INVINCIBLE) {
+            w->player.state = STATE_FALLING;
+            w->is_falling_animation = true;
+        } else if (w->powerup_time > 0.0f &&
+                   w->powerup_type == OBJECT_EGG_INVINCIBLE) {
             /* Player is invincible, ignore collision */
         } else {
-            play_kill_player();
+            play_kill_player(w);
         }
         return;
     }
 
     /* Player vs powerup collisions */
-    if (is_player_powerup(obj1, obj2)) {
-        object_t *powerup = (obj1 == &player) ? obj2 : obj1;
-        collect_powerup(powerup);
+    if (is_player_powerup(w, obj1, obj2)) {
+        object_t *powerup = (obj1 == &w->player) ? obj2 : obj1;
+        collect_powerup(w, powerup);
     }
 }
 
@@ -360,35 +447,126 @@ static void spatial_collision_check_pair(object_t *obj1, object_t *obj2)
  *
  * Apply power-up effects and remove from game
  */
-static void collect_powerup(object_t *powerup)
+static void collect_powerup(world_t *w, object_t *powerup)
 {
     const game_config_t *cfg = ensure_cfg();
 
     if (powerup->type == OBJECT_EGG_INVINCIBLE) {
-        powerup_time = cfg->powerups.duration;
-        powerup_type = OBJECT_EGG_INVINCIBLE;
+        w->powerup_time = cfg->powerups.duration;
+        w->powerup_type = OBJECT_EGG_INVINCIBLE;
         powerup->x = OFFSCREEN_X;
-        user_score += cfg->scoring.powerup_collect;
+        w->user_score += cfg->scoring.powerup_collect;
     } else if (powerup->type == OBJECT_EGG_FIRE) {
-        powerup_time = cfg->powerups.duration;
-        powerup_type = OBJECT_EGG_FIRE;
+        w->powerup_time = cfg->powerups.duration;
+        w->powerup_type = OBJECT_EGG_FIRE;
         powerup->x = OFFSCREEN_X;
-        user_score += cfg->scoring.powerup_collect;
+        w->user_score += cfg->scoring.powerup_collect;
     }
 }
 
-/* Ring buffer to store game objects - fixed-size, no dynamic allocation */
-static object_ring_buffer_t objects_ring;
-
 /* Macro to iterate over all objects in ring buffer
  * Snapshots count and front to ensure stability during iteration
  */
-#define FOR_EACH_OBJECT(obj_ptr)                                    \
-    for (int __rb_i = 0, __rb_n = ring_buffer_count(&objects_ring), \
-             __rb_pos = objects_ring.front;                         \
-         __rb_i < __rb_n;                                           \
-         ++__rb_i, __rb_pos = (__rb_pos + 1) % RING_BUFFER_SIZE)    \
-        if ((obj_ptr = &objects_ring.items[__rb_pos]))
+#define FOR_EACH_OBJECT(world, obj_ptr)                                  \
+    for (int __rb_i = 0, __rb_n = ring_buffer_count(&(world)->objects), \
+             __rb_pos = (world)->objects.front;                         \
+         __rb_i < __rb_n;                                               \
+         ++__rb_i, __rb_pos = (__rb_pos + 1) % RING_BUFFER_SIZE)        \
+        if ((obj_ptr = &(world)->objects.items[__rb_pos]))
+
+/*
+ * Alias tables
+ *
+ * Walker's alias method turns the probability ranges of the configuration
+ * into a table that is sampled in constant time: pick a column uniformly,
+ * then either the column's own type or its alias with a fixed split. Weights
+ * are integers, so the tables are built exactly (Vose's variant) and hold
+ * the same distribution as the ranges.
+ *
+ * One table covers every type, the other one leaves the eggs out for while
+ * a power-up is active. Both depend on the shared configuration only.
+ */
+#define ALIAS_MAX_TYPES 16
+
+typedef struct {
+    int count, total; /* Columns, sum of the weights */
+
+    /* Column i yields type[i] below split[i], else type[alias[i]] */
+    object_type_t type[ALIAS_MAX_TYPES];
+    int split[ALIAS_MAX_TYPES];
+    int alias[ALIAS_MAX_TYPES];
+} alias_table_t;
+
+static alias_table_t spawn_any, spawn_no_egg;
+static pthread_once_t spawn_tables_once = PTHREAD_ONCE_INIT;
+
+static bool is_egg(object_type_t type)
+{
+    return type >= OBJECT_EGG_INVINCIBLE;
+}
+
+static void alias_build(alias_table_t *t, bool with_eggs)
+{
+    const object_probability_t *probs = config_get_probs();
+    int count = config_get_prob_count();
+    int scaled[ALIAS_MAX_TYPES];
+    int small[ALIAS_MAX_TYPES], large[ALIAS_MAX_TYPES];
+    int n_small = 0, n_large = 0;
+
+    t->count = 0;
+    t->total = 0;
+    for (int i = 0; i < count && t->count < ALIAS_MAX_TYPES; i++) {
+        if (!with_eggs && is_egg(probs[i].object_type))
+            continue;
+        t->type[t->count] = probs[i].object_type;
+        scaled[t->count] = probs[i].range_end - probs[i].range_start;
+        t->total += scaled[t->count];
+        t->count++;
+    }
+
+    /* Scale by the column count so that a full column weighs total */
+    for (int i = 0; i < t->count; i++) {
+        scaled[i] *= t->count;
+        t->alias[i] = i;
+        if (scaled[i] < t->total)
+            small[n_small++] = i;
+        else
+            large[n_large++] = i;
+    }
+
+    /* Top up every light column with the excess of a heavy one */
+    while (n_small && n_large) {
+        int s = small[--n_small], l = large[n_large - 1];
+        t->split[s] = scaled[s];
+        t->alias[s] = l;
+        scaled[l] -= t->total - scaled[s];
+        if (scaled[l] < t->total) {
+            n_large--;
+            small[n_small++] = l;
+        }
+    }
+    while (n_large)
+        t->split[large[--n_large]] = t->total;
+    while (n_small)
+        t->split[small[--n_small]] = t->total;
+}
+
+static void spawn_tables_build(void)
+{
+    alias_build(&spawn_any, true);
+    alias_build(&spawn_no_egg, false);
+}
+
+static object_type_t alias_sample(const alias_table_t *t, unsigned int *seed)
+{
+    if (t->count == 0)
+        return OBJECT_CACTUS;
+
+    int r = rand_r(seed) % (t->count * t->total);
+    int col = r % t->count;
+    return r / t->count < t->split[col] ? t->type[col]
+                                        : t->type[t->alias[col]];
+}
 
 /**
  * Generate a random object type based on probability
@@ -396,42 +574,99 @@ static object_ring_buffer_t objects_ring;
  *
  * Return randomly selected object type
  */
-object_type_t play_random_object(bool b_generate_egg)
+object_type_t play_random_object(world_t *w, bool b_generate_egg)
+{
+    pthread_once(&spawn_tables_once, spawn_tables_build);
+    return alias_sample(b_generate_egg ? &spawn_any : &spawn_no_egg,
+                        &w->seed);
+}
+
+/* Milliseconds between two spawns at the current level */
+static float spawn_delay(world_t *w)
 {
-    /* Generate random value between 1 and 10000 with overflow protection */
-    long rand_val = random();
-    int random_value = (int) (rand_val % 10000) + 1;
+    const level_config_t *level = config_get_level(w->current_level + 1);
+    return level->spawn_min +
+           (rand_r(&w->seed) % (level->spawn_max - level->spawn_min));
+}
 
-    const object_probability_t *probs = config_get_probs();
-    int count = config_get_prob_count();
+static spawn_slot_t *spawn_slot(world_t *w, int i)
+{
+    return &w->spawns[(w->spawn_head + i) % SPAWN_LOOKAHEAD];
+}
 
-    for (int i = 0; i < count; i++) {
-        /* Is the generated value within range of any object? */
-        if (random_value >= probs[i].range_start &&
-            random_value < probs[i].range_end) {
-            /* Generated an egg but shouldn't have? Then generate again */
-            if (probs[i].object_type >= OBJECT_EGG_INVINCIBLE &&
-                !b_generate_egg)
-                return play_random_object(b_generate_egg);
-            return probs[i].object_type;
-        }
+/* Plan spawns until the lookahead queue is full */
+static void spawn_plan_fill(world_t *w)
+{
+    while (w->spawn_count < SPAWN_LOOKAHEAD) {
+        spawn_slot_t *slot = spawn_slot(w, w->spawn_count++);
+        slot->type = play_random_object(w, true);
+        slot->delay = spawn_delay(w);
     }
+}
+
+/* Level changed: keep the planned types, retime all but the pending spawn */
+static void spawn_plan_retime(world_t *w)
+{
+    for (int i = 1; i < w->spawn_count; i++)
+        spawn_slot(w, i)->delay = spawn_delay(w);
+}
+
+/*
+ * Take the next planned spawn off the queue and plan a new one. Eggs are
+ * planned unconditionally; one that comes due while a power-up is active is
+ * replaced by a draw without eggs, as play_random_object() would do.
+ */
+static object_type_t spawn_plan_pop(world_t *w)
+{
+    object_type_t type = spawn_slot(w, 0)->type;
+    w->spawn_head = (w->spawn_head + 1) % SPAWN_LOOKAHEAD;
+    w->spawn_count--;
+    spawn_plan_fill(w);
+
+    if (is_egg(type) && w->powerup_time > 0.0f)
+        type = play_random_object(w, false);
+    return type;
+}
 
-    return OBJECT_CACTUS;
+/**
+ * Look at the spawns planned for a world
+ * @w : world to inspect
+ * @plan : receives up to @max spawns, soonest first
+ * @max : capacity of @plan
+ *
+ * The plan holds as the game goes on, except that a level change retimes
+ * every spawn but the next one, and an egg may be swapped for an obstacle
+ * when it comes due during a power-up.
+ *
+ * Return number of entries written
+ */
+int play_world_upcoming(const world_t *w, spawn_plan_t *plan, int max)
+{
+    double eta = -w->f_time_random;
+    int n = max < w->spawn_count ? max : w->spawn_count;
+
+    for (int i = 0; i < n; i++) {
+        const spawn_slot_t *slot =
+            &w->spawns[(w->spawn_head + i) % SPAWN_LOOKAHEAD];
+        eta += slot->delay;
+        plan[i].type = slot->type;
+        plan[i].eta = eta > 0.0 ? eta : 0.0;
+    }
+    return n;
 }
 
-int play_find_free_slot()
+int play_find_free_slot(world_t *w)
 {
     /* Ring buffer manages space automatically - always returns 0 if space
      * available */
-    return ring_buffer_is_full(&objects_ring) ? -1 : 0;
+    return ring_buffer_is_full(&w->objects) ? -1 : 0;
 }
 
-void play_cleanup_objects()
+void play_cleanup_objects(world_t *w)
 {
     /* Simply reinitialize the ring buffer - no need to free individual objects
      */
-    ring_buffer_init(&objects_ring);
+    ring_buffer_init(&w->objects);
 }
 
 /**
@@ -441,7 +676,7 @@ void play_cleanup_objects()
  * @g : Pointer to store green component (0-255)
  * @b : Pointer to store blue component (0-255)
  */
-static void get_trex_color(short *r, short *g, short *b)
+static void get_trex_color(const world_t *w, short *r, short *g, short *b)
 {
     const game_config_t *cfg = ensure_cfg();
 
@@ -449,19 +684,19 @@ static void get_trex_color(short *r, short *g, short *b)
     *g = cfg->colors.trex_normal.g;
     *b = cfg->colors.trex_normal.b;
 
-    if (is_dead) {
+    if (w->is_dead) {
         *r = cfg->colors.trex_dead.r;
         *g = cfg->colors.trex_dead.g;
         *b = cfg->colors.trex_dead.b;
         return;
     }
 
-    if (powerup_time > 0.0f) {
-        if (powerup_type == OBJECT_EGG_INVINCIBLE) {
+    if (w->powerup_time > 0.0f) {
+        if (w->powerup_type == OBJECT_EGG_INVINCIBLE) {
             *r = cfg->colors.trex_invincible.r;
             *g = cfg->colors.trex_invincible.g;
             *b = cfg->colors.trex_invincible.b;
-        } else if (powerup_type == OBJECT_EGG_FIRE) {
+        } else if (w->powerup_type == OBJECT_EGG_FIRE) {
             *r = cfg->colors.trex_fire.r;
             *g = cfg->colors.trex_fire.g;
             *b = cfg->colors.trex_fire.b;
@@ -469,20 +704,17 @@ static void get_trex_color(short *r, short *g, short *b)
     }
 }
 
-/**
- * Get bounding rectangle for any object
- * @obj : Object to get bounds for
- *
- * Return bounding rectangle in world coordinates
- */
 /**
  * Get object bounding rectangle with optional player adjustments
+ * @w : World the object lives in, for the sprite scale
  * @obj : Object to get bounds for
  * @is_player : If true, apply player-specific duck adjustments
  *
  * Return bounding rectangle, with duck adjustments if is_player and ducking
  */
-static bounding_rect_t get_bounds(const object_t *obj, bool is_player)
+static bounding_rect_t get_bounds(const world_t *w,
+                                  const object_t *obj,
+                                  bool is_player)
 {
     bounding_rect_t bounds = {0};
     if (!obj)
@@ -495,13 +727,31 @@ static bounding_rect_t get_bounds(const object_t *obj, bool is_player)
 
     /* Apply player-specific duck adjustments */
     if (is_player && obj->state == STATE_DUCK) {
-        bounds.top += DUCK_HITBOX_TOP_OFFSET;
-        bounds.right += DUCK_HITBOX_RIGHT_EXTEND;
+        bounds.top += DUCK_HITBOX_TOP_OFFSET * w->scale;
+        bounds.right += DUCK_HITBOX_RIGHT_EXTEND * w->scale;
     }
 
     return bounds;
 }
 
+/*
+ * Stretch the bounds of a moving object over the cells it crossed in this
+ * update, so that an object moving several cells at once cannot pass
+ * through another one between two updates. The player does not move along
+ * x, fireballs move right and everything else scrolls left.
+ */
+static void sweep_bounds(const world_t *w,
+                         const object_t *obj,
+                         bounding_rect_t *bounds)
+{
+    if (obj == &w->player)
+        return;
+    if (obj->type == OBJECT_FIRE_BALL)
+        bounds->left -= w->scroll_step;
+    else
+        bounds->right += w->scroll_step;
+}
+
 /**
  * Check if two bounding rectangles overlap
  * @rect1 : First bounding rectangle
@@ -539,10 +789,12 @@ static bool involves_ground_hole(object_t const *obj1, object_t const *obj2)
  *
  * Return true if one is player and other is enemy
  */
-static bool is_player_enemy(object_t const *obj1, object_t const *obj2)
+static bool is_player_enemy(const world_t *w,
+                            object_t const *obj1,
+                            object_t const *obj2)
 {
-    return ((obj1 == &player && obj2->enemy) ||
-            (obj2 == &player && obj1->enemy));
+    return ((obj1 == &w->player && obj2->enemy) ||
+            (obj2 == &w->player && obj1->enemy));
 }
 
 /**
@@ -552,13 +804,15 @@ static bool is_player_enemy(object_t const *obj1, object_t const *obj2)
  *
  * Return true if one is player and other is powerup (non-enemy)
  */
-static bool is_player_powerup(object_t const *obj1, object_t const *obj2)
+static bool is_player_powerup(const world_t *w,
+                              object_t const *obj1,
+                              object_t const *obj2)
 {
     if (!obj1 || !obj2)
         return false;
 
-    return ((obj1 == &player && !obj2->enemy) ||
-            (obj2 == &player && !obj1->enemy));
+    return ((obj1 == &w->player && !obj2->enemy) ||
+            (obj2 == &w->player && !obj1->enemy));
 }
 
 /**
@@ -566,67 +820,73 @@ static bool is_player_powerup(object_t const *obj1, object_t const *obj2)
  *
  * Return true if player is grounded (running or ducking)
  */
-static inline bool is_player_on_ground(void)
+static inline bool is_player_on_ground(const world_t *w)
 {
-    return player.height <= 0 &&
-           (player.state == STATE_RUNNING || player.state == STATE_DUCK);
+    return w->player.height <= 0 &&
+           (w->player.state == STATE_RUNNING || w->player.state == STATE_DUCK);
+}
+
+/* Stamp of an event that has not happened */
+#define CLOCK_NEVER INT64_MIN
+
+/* Nanoseconds on the world clock since @stamp */
+static inline int64_t clock_since(const world_t *w, int64_t stamp)
+{
+    return stamp == CLOCK_NEVER ? INT64_MAX : w->clock_ns - stamp;
 }
 
 /* Record jump key press for buffering */
-static void on_keydown_jump(void)
+static void on_keydown_jump(world_t *w)
 {
-    last_jump_keydown = TICKCOUNT;
+    w->last_jump_keydown = w->clock_ns;
 }
 
 /* Attempt to execute a jump with buffer and coyote time */
-static void try_jump(void)
+static void try_jump(world_t *w)
 {
-    if (is_dead || is_falling_animation)
+    if (w->is_dead || w->is_falling_animation)
         return;
 
-    bool grounded_now = is_player_on_ground();
-    double current_time = TICKCOUNT;
+    bool grounded_now = is_player_on_ground(w);
 
     if (grounded_now) {
-        left_ground_at = 0.0;
-    } else if (left_ground_at == 0.0) {
-        left_ground_at = current_time;
+        w->left_ground_at = CLOCK_NEVER;
+    } else if (w->left_ground_at == CLOCK_NEVER) {
+        w->left_ground_at = w->clock_ns;
     }
 
-    bool buffered = (current_time - last_jump_keydown) < JUMP_BUFFER_MS;
-    bool in_coyote = (left_ground_at > 0.0) &&
-                     (current_time - left_ground_at) < COYOTE_TIME_MS;
+    bool buffered =
+        clock_since(w, w->last_jump_keydown) < JUMP_BUFFER_MS * NS_PER_MS;
+    bool in_coyote =
+        clock_since(w, w->left_ground_at) < COYOTE_TIME_MS * NS_PER_MS;
 
     if (buffered && (grounded_now || in_coyote)) {
-        player.state = STATE_JUMPING;
-        player.frame = 0;
-        last_jump_keydown = 0.0;
-        is_fast_falling = false; /* Reset fast-fall when starting new jump */
+        w->player.state = STATE_JUMPING;
+        w->player.frame = 0;
+        w->last_jump_keydown = CLOCK_NEVER;
+        w->is_fast_falling = false; /* Reset fast-fall when starting new jump */
     }
 }
 
 /* Helper function to render T-Rex object */
-static void render_trex(const object_t *object)
+static void render_trex(const world_t *w, const object_t *object)
 {
     /* Get appropriate T-Rex color based on game state */
     short s_color_r, s_color_g, s_color_b;
-    get_trex_color(&s_color_r, &s_color_g, &s_color_b);
+    get_trex_color(w, &s_color_r, &s_color_g, &s_color_b);
 
     /* Select appropriate sprite based on state */
     const sprite_t *sprite =
         (object->state == STATE_DUCK) ? &sprite_trex_duck : &sprite_trex_normal;
 
-    /* Draw T-Rex using sprite data */
+    /* Draw T-Rex one run of pixels at a time */
+    int s = w->scale;
+    const sprite_runs_t *runs = sprite_runs(sprite, s);
     int base_y = object->y - object->height;
-    for (int i = 0; i < sprite->rows; i++) {
-        int y_pos = base_y + i;
-        for (int j = 0; j < sprite->cols; j++) {
-            if (!sprite_get_pixel(sprite, i, j))
-                continue;
-
-            draw_block_color(object->x + j, y_pos, 1, 1, s_color_r, s_color_g,
-                             s_color_b);
-        }
+    for (int i = 0; i < runs->count; i++) {
+        const sprite_run_t *run = &runs->runs[i];
+        draw_block_color(object->x + run->x, base_y + run->y, run->cols,
+                         run->rows, s_color_r, s_color_g, s_color_b);
     }
 
     /* Skip leg animation if ducking or not animated */
@@ -659,52 +919,51 @@ static void render_trex(const object_t *object)
         const int (*rects)[4] = leg_frames[object->frame];
         /* clang-format on */
         for (int i = 0; i < 5; i++) {
-            draw_block_color(object->x + rects[i][0],
-                             object->y + rects[i][1] - object->height,
-                             rects[i][2], rects[i][3], s_color_r, s_color_g,
-                             s_color_b);
+            draw_block_color(object->x + rects[i][0] * s,
+                             base_y + rects[i][1] * s, rects[i][2] * s,
+                             rects[i][3] * s, s_color_r, s_color_g, s_color_b);
         }
     }
 }
 
 /* Helper function to render sprite-based objects */
-static void render_sprite_object(const object_t *object,
+static void render_sprite_object(const world_t *w,
+                                 const object_t *object,
                                  const sprite_t *sprite,
                                  short r,
                                  short g,
                                  short b)
 {
+    const sprite_runs_t *runs = sprite_runs(sprite, w->scale);
     int base_y = object->y - object->height;
-    for (int i = 0; i < object->rows; ++i) {
-        int y_pos = base_y + i;
-        for (int j = 0; j < object->cols; ++j) {
-            if (!sprite_get_pixel(sprite, i, j))
-                continue;
-
-            draw_block_color(object->x + j, y_pos, 1, 1, r, g, b);
-        }
+    for (int i = 0; i < runs->count; i++) {
+        const sprite_run_t *run = &runs->runs[i];
+        draw_block_color(object->x + run->x, base_y + run->y, run->cols,
+                         run->rows, r, g, b);
     }
 }
 
 /* Render ground hole */
-static void render_ground_hole(const object_t *object)
+static void render_ground_hole(const world_t *w, const object_t *object)
 {
     draw_block(object->x, object->y - object->height, object->cols,
                object->rows, TUI_COLOR_PAIR(1));
-    short r = is_dead ? 178 : 182;
-    short g = is_dead ? 178 : 122;
-    short b = is_dead ? 178 : 87;
-    draw_block_color(object->x - 2, object->y - object->height, 2, 5, r, g, b);
-    draw_block_color(object->x + object->cols, object->y - object->height, 2, 5,
-                     r, g, b);
+    short r = w->is_dead ? 178 : 182;
+    short g = w->is_dead ? 178 : 122;
+    short b = w->is_dead ? 178 : 87;
+    int edge = 2 * w->scale;
+    draw_block_color(object->x - edge, object->y - object->height, edge,
+                     object->rows, r, g, b);
+    draw_block_color(object->x + object->cols, object->y - object->height,
+                     edge, object->rows, r, g, b);
 }
 
 /* Render fireball */
-static void render_fireball(const object_t *object)
+static void render_fireball(const world_t *w, const object_t *object)
 {
-    draw_block_color(object->x, object->y - object->height, 2, 1,
-                     is_dead ? 178 : 182, is_dead ? 178 : 122,
-                     is_dead ? 178 : 87);
+    draw_block_color(object->x, object->y - object->height, object->cols,
+                     object->rows, w->is_dead ? 178 : 182,
+                     w->is_dead ? 178 : 122, w->is_dead ? 178 : 87);
 }
 
 /* Egg color lookup tables */
@@ -724,9 +983,13 @@ static const short egg_colors[2][3][3] = {
 };
 
 /* Get egg colors based on type and frame */
-static void get_egg_colors(const object_t *object, short *r, short *g, short *b)
+static void get_egg_colors(const world_t *w,
+                           const object_t *object,
+                           short *r,
+                           short *g,
+                           short *b)
 {
-    if (is_dead) {
+    if (w->is_dead) {
         *r = *g = *b = 170;
         return;
     }
@@ -746,7 +1009,7 @@ static void get_egg_colors(const object_t *object, short *r, short *g, short *b)
     }
 }
 
-void play_render_object(object_t const *object)
+void play_render_object(const world_t *w, object_t const *object)
 {
     if (!object)
         return;
@@ -755,19 +1018,19 @@ void play_render_object(object_t const *object)
 
     /* Handle T-Rex rendering */
     if (object->type == OBJECT_TREX) {
-        render_trex(object);
+        render_trex(w, object);
         return;
     }
 
     /* Handle ground hole rendering */
     if (object->type == OBJECT_GROUND_HOLE) {
-        render_ground_hole(object);
+        render_ground_hole(w, object);
         return;
     }
 
     /* Handle fireball rendering */
     if (object->type == OBJECT_FIRE_BALL) {
-        render_fireball(object);
+        render_fireball(w, object);
         return;
     }
 
@@ -777,9 +1040,9 @@ void play_render_object(object_t const *object)
 
     switch (object->type) {
     case OBJECT_CACTUS:
-        r = is_dead ? 130 : cfg->colors.cactus.r;
-        g = is_dead ? 130 : cfg->colors.cactus.g;
-        b = is_dead ? 130 : cfg->colors.cactus.b;
+        r = w->is_dead ? 130 : cfg->colors.cactus.r;
+        g = w->is_dead ? 130 : cfg->colors.cactus.g;
+        b = w->is_dead ? 130 : cfg->colors.cactus.b;
         sprite = &sprite_cactus;
         break;
 
@@ -792,14 +1055,14 @@ void play_render_object(object_t const *object)
 
     case OBJECT_EGG_INVINCIBLE:
     case OBJECT_EGG_FIRE:
-        get_egg_colors(object, &r, &g, &b);
+        get_egg_colors(w, object, &r, &g, &b);
         sprite = &sprite_egg;
         break;
 
     case OBJECT_PTERODACTYL:
-        r = is_dead ? 90 : cfg->colors.pterodactyl.r;
-        g = is_dead ? 90 : cfg->colors.pterodactyl.g;
-        b = is_dead ? 90 : cfg->colors.pterodactyl.b;
+        r = w->is_dead ? 90 : cfg->colors.pterodactyl.r;
+        g = w->is_dead ? 90 : cfg->colors.pterodactyl.g;
+        b = w->is_dead ? 90 : cfg->colors.pterodactyl.b;
         sprite = &sprite_pterodactyl;
         break;
 
@@ -809,7 +1072,7 @@ void play_render_object(object_t const *object)
 
     /* Render the sprite if found */
     if (sprite)
-        render_sprite_object(object, sprite, r, g, b);
+        render_sprite_object(w, object, sprite, r, g, b);
 }
 
 /**
@@ -818,7 +1081,7 @@ void play_render_object(object_t const *object)
  * @y : Y coordinate for the new object
  * @type : Type of object to create (must be valid object type)
  */
-void play_add_object(int x, int y, object_type_t type)
+void play_add_object(world_t *w, int x, int y, object_type_t type)
 {
     const game_config_t *cfg = ensure_cfg();
 
@@ -827,7 +1090,7 @@ void play_add_object(int x, int y, object_type_t type)
         return; /* Invalid object type */
 
     /* Check if ring buffer has space */
-    if (ring_buffer_is_full(&objects_ring))
+    if (ring_buffer_is_full(&w->objects))
         return; /* Buffer full - silently fail */
 
     /* Create object on stack */
@@ -836,10 +1099,11 @@ void play_add_object(int x, int y, object_type_t type)
         .y = y,
         .type = type,
     };
-    play_init_object(&object);
+    play_init_object(w, &object);
 
     /* Push to ring buffer - copies the object */
-    ring_buffer_push(&objects_ring, &object);
+    if (ring_buffer_push(&w->objects, &object))
+        PROBE3(spawn, type, x, y);
 }
 
 /* Object initialization data structure */
@@ -863,21 +1127,35 @@ static const object_init_t object_init_data[] = {
     [OBJECT_FIRE_BALL] = {NULL, 1, 0, 0, 2, 1, 0, false},
 };
 
-void play_init_object(object_t *object)
+/**
+ * Size an object for the scale of its world
+ * @w : world the object lives in
+ * @object : object with its type and position set
+ *
+ * Sprites, hitboxes and the offset from the ground line all grow with the
+ * scale. Ground holes only get wider: they are cut into the ground band,
+ * whose height does not change.
+ */
+void play_init_object(const world_t *w, object_t *object)
 {
     if (!object || object->type < 0 || object->type > OBJECT_FIRE_BALL)
         return;
 
     const object_init_t *data = &object_init_data[object->type];
+    int s = w->scale;
+    int y_adjust = data->y_adjust * s;
 
     /* Set sprite dimensions */
     if (data->sprite) {
-        object->cols = data->sprite->cols;
-        object->rows = data->sprite->rows;
+        object->cols = data->sprite->cols * s;
+        object->rows = data->sprite->rows * s;
+    } else if (object->type == OBJECT_GROUND_HOLE) {
+        object->cols = 21 * s;
+        object->rows = 5;
+        y_adjust = data->y_adjust;
     } else {
-        /* Ground hole and fireball have hardcoded dimensions */
-        object->cols = (object->type == OBJECT_GROUND_HOLE) ? 21 : 2;
-        object->rows = (object->type == OBJECT_GROUND_HOLE) ? 5 : 1;
+        object->cols = 2 * s;
+        object->rows = s;
     }
 
     object->height = HEIGHT_ZERO;
@@ -887,189 +1165,377 @@ void play_init_object(object_t *object)
     /* Set bounding box in one go */
     /* clang-format off */
     object->bounding_box = (bounding_box_t) {
-        .x = data->bbox_x,
-        .y = data->bbox_y,
-        .width = data->bbox_width,
-        .height = data->bbox_height,
+        .x = data->bbox_x * s,
+        .y = data->bbox_y * s,
+        .width = data->bbox_width * s,
+        .height = data->bbox_height * s,
     };
     /* clang-format on */
 
     /* Combined y adjustments */
-    object->y += data->y_adjust - object->rows;
+    object->y += y_adjust - object->rows;
 }
 
-void play_kill_player()
+void play_kill_player(world_t *w)
 {
-    is_dead = true;
+    w->is_dead = true;
 }
 
-void play_init_world()
+/* Largest sprite scale whose play area fits on a @rows x @cols surface */
+static int world_scale(int rows, int cols)
 {
-    /* Initialize random number generator once */
-    static bool rng_initialized = false;
-    if (!rng_initialized) {
-        srand(time(NULL));
-        rng_initialized = true;
-    }
+    int by_rows = (rows - SCALE_BANDS) / SCALE_ROWS;
+    int by_cols = cols / SCALE_COLS;
+    int scale = by_rows < by_cols ? by_rows : by_cols;
+
+    if (scale < 1)
+        return 1;
+    return scale > SPRITE_SCALE_MAX ? SPRITE_SCALE_MAX : scale;
+}
 
+/* Place the player on the ground line at the spawn column */
+static void place_player(world_t *w)
+{
+    const player_spawn_t *spawn = config_get_spawn();
+    w->player.x = spawn->x * w->scale;
+    w->player.y = w->rows - spawn->y_offset;
+    play_init_object(w, &w->player);
+}
+
+/* Defaults for the fields play_world_reset() leaves untouched */
+static void world_init(world_t *w, int rows, int cols, unsigned int seed)
+{
+    memset(w, 0, sizeof(*w));
+    w->rows = rows;
+    w->cols = cols;
+    w->seed = seed;
+    w->powerup_time = -1;
+    w->last_key_check_time = CLOCK_NEVER;
+    w->last_fast_fall_time = CLOCK_NEVER;
+    w->can_throw_fireball = true;
+    w->fast_fall_multiplier = FAST_FALL_MULTIPLIER;
+    spatial_init(w);
+}
+
+world_t *play_world_new(int rows, int cols, unsigned int seed)
+{
+    world_t *w = malloc(sizeof(world_t));
+    if (!w)
+        return NULL;
+
+    world_init(w, rows, cols, seed);
+    play_world_reset(w);
+    return w;
+}
+
+void play_world_free(world_t *w)
+{
+    if (!w)
+        return;
+
+    spatial_free(w);
+    free(w);
+}
+
+void play_world_reset(world_t *w)
+{
     /* Initialize ring buffer - no dynamic allocation needed */
-    ring_buffer_init(&objects_ring);
+    ring_buffer_init(&w->objects);
 
     /* Reset game settings */
-    const level_config_t *level = config_get_level(current_level + 1);
-    obstacle_time =
-        level->spawn_min + (random() % (level->spawn_max - level->spawn_min));
-    const player_spawn_t *spawn = config_get_spawn();
-    player.x = spawn->x;
-    player.y = RESOLUTION_ROWS - spawn->y_offset;
-    player.type = OBJECT_TREX;
-    player.state = STATE_JUMPING;
-    player.rows = 15; /* T-Rex dimensions are fixed */
-    player.cols = 22;
-    player.height = 0;     /* Starting height offset */
-    player.frame = 0;      /* Animation frame */
-    player.max_frames = 3; /* T-Rex has 3 animation frames */
-
-    current_level = 0;
-    user_score = 0;
-    distance = 0;
-    is_falling_animation = false;
-    is_dead = false;
+    w->scale = world_scale(w->rows, w->cols);
+    w->player.type = OBJECT_TREX;
+    w->player.state = STATE_JUMPING;
+    w->player.frame = 0; /* Animation frame */
+
+    w->current_level = 0;
+    w->user_score = 0;
+    w->distance = 0;
+    w->is_falling_animation = false;
+    w->is_dead = false;
 
     /* Reset jump buffer and coyote time state */
-    last_jump_keydown = 0.0;
-    left_ground_at = 0.0;
+    w->last_jump_keydown = CLOCK_NEVER;
+    w->left_ground_at = CLOCK_NEVER;
 
     /* Reset streak counters */
-    aerial_streak = 0;
-    max_streak = 0;
-    was_airborne_last_frame = false;
-    cleared_obstacle_while_airborne = false;
-
-    /* Initialize the player again */
-    play_init_object(&player);
+    w->aerial_streak = 0;
+    w->max_streak = 0;
+    w->was_airborne_last_frame = false;
+    w->cleared_obstacle_while_airborne = false;
+
+    w->scroll_frac = 0;
+    w->scroll_step = 0;
+
+    /* Restart update timers */
+    w->f_time_10ms = 0.0;
+    w->f_time_150ms = 0.0;
+    w->f_time_random = 0.0;
+
+    /* Plan the first spawns for level 1 */
+    w->spawn_head = 0;
+    w->spawn_count = 0;
+    spawn_plan_fill(w);
+
+    /* Size the player for the scale and put it on the ground */
+    place_player(w);
 }
 
-void play_adjust_for_resize()
+void play_world_resize(world_t *w, int rows, int cols)
 {
-    const player_spawn_t *spawn = config_get_spawn();
-    int new_player_y = RESOLUTION_ROWS - spawn->y_offset;
+    w->rows = rows;
+    w->cols = cols;
+
+    /* Obstacles of another size would not match the physics, drop them */
+    int scale = world_scale(rows, cols);
+    if (scale != w->scale) {
+        ring_buffer_init(&w->objects);
+        w->scale = scale;
+    }
 
-    /* Adjust player position to maintain relative position on screen */
-    if (new_player_y > 0)
-        player.y = new_player_y;
+    /* Keep the player on the ground line, at the same height in its own
+     * sizes, and in whatever state it was
+     */
+    int height = w->player.height;
+    int old_rows = w->player.rows;
+    place_player(w);
+    w->player.height = height * w->player.rows / old_rows;
 
     /* Mark objects outside screen bounds as invalid */
     object_t *obj;
-    FOR_EACH_OBJECT (obj) {
+    FOR_EACH_OBJECT (w, obj) {
         /* Mark as invalid if way outside bounds (will be cleaned up later) */
-        if (obj->y < -50 || obj->y > RESOLUTION_ROWS + 50 || obj->x < -100 ||
-            obj->x > RESOLUTION_COLS + 100) {
+        if (obj->y < -50 || obj->y > w->rows + 50 || obj->x < -100 ||
+            obj->x > w->cols + 100) {
             obj->x = INVALID_X_SENTINEL; /* Mark invalid with sentinel value */
         }
     }
 
     /* Clean up invalid objects */
-    ring_buffer_cleanup_invalid(&objects_ring);
+    ring_buffer_cleanup_invalid(&w->objects);
+}
+
+int play_world_score(const world_t *w)
+{
+    return w->user_score;
+}
+
+int play_world_level(const world_t *w)
+{
+    return w->current_level + 1;
+}
+
+bool play_world_is_dead(const world_t *w)
+{
+    return w->is_dead;
+}
+
+int play_world_object_count(const world_t *w)
+{
+    return ring_buffer_count(&w->objects);
+}
+
+void play_init_world()
+{
+    /* Initialize random number generator once */
+    static bool rng_initialized = false;
+    if (!rng_initialized) {
+        world_init(&main_world, RESOLUTION_ROWS, RESOLUTION_COLS, time(NULL));
+        rng_initialized = true;
+    }
+
+    main_world.rows = RESOLUTION_ROWS;
+    main_world.cols = RESOLUTION_COLS;
+    play_world_reset(&main_world);
+}
+
+void play_adjust_for_resize()
+{
+    play_world_resize(&main_world, RESOLUTION_ROWS, RESOLUTION_COLS);
+}
+
+void play_update_world(int64_t step_ns)
+{
+    bool was_dead = main_world.is_dead;
+    play_world_update(&main_world, step_ns);
+
+    /* Only games played by hand go into the shared table */
+    if (!was_dead && main_world.is_dead)
+        board_submit(main_world.user_score);
+}
+
+void play_render_world()
+{
+    play_world_render(&main_world);
+}
+
+void play_handle_input(int input)
+{
+    play_world_handle_input(&main_world, input);
+}
+
+int play_object_count(void)
+{
+    return play_world_object_count(&main_world);
 }
 
-void play_update_world(double elapsed)
+bool play_is_dead(void)
+{
+    return play_world_is_dead(&main_world);
+}
+
+int play_score(void)
+{
+    return play_world_score(&main_world);
+}
+
+int play_level(void)
+{
+    return play_world_level(&main_world);
+}
+
+/* The spatial index is rebuilt every frame, the world keeps nothing else */
+void play_hibernate(void)
+{
+    spatial_free(&main_world);
+}
+
+void play_wake(void)
+{
+    if (!main_world.spatial.buckets)
+        spatial_init(&main_world);
+}
+
+/* Scroll speed in cells of the scaled sprites */
+static int scroll_speed(const world_t *w)
+{
+    return play_world_speed(w) * w->scale;
+}
+
+/**
+ * Current scroll speed of a world
+ * @w : world to inspect
+ *
+ * The speed follows the curve of the current level, from its start to its
+ * end speed as the score goes from the previous level threshold to the next.
+ *
+ * Return speed in 1/SPEED_ONE cells per update
+ */
+int play_world_speed(const world_t *w)
+{
+    const level_config_t *level = config_get_level(w->current_level + 1);
+    int from = w->current_level > 0
+                   ? config_get_level(w->current_level)->score_next
+                   : 0;
+    int span = level->score_next - from;
+    int progress = w->user_score - from;
+
+    if (span <= 0 || progress >= span)
+        return level->speed_end;
+    if (progress <= 0)
+        return level->speed_start;
+    return level->speed_start +
+           (level->speed_end - level->speed_start) * progress / span;
+}
+
+void play_world_update(world_t *w, int64_t step_ns)
 {
     const game_config_t *cfg = ensure_cfg();
+    double elapsed = (double) step_ns / NS_PER_MS;
 
-    static double f_time_10ms = 0.0f;
-    static double f_time_150ms = 0.0f;
-    static double f_time_random = 0.0f;
+    w->clock_ns += step_ns;
 
-    f_time_10ms += elapsed;
-    f_time_150ms += elapsed;
-    f_time_random += elapsed;
+    w->f_time_10ms += elapsed;
+    w->f_time_150ms += elapsed;
+    w->f_time_random += elapsed;
 
     /* If using any powerup, decrease its total time */
-    if (powerup_time > 0.0f)
-        powerup_time -= elapsed;
+    if (w->powerup_time > 0.0f)
+        w->powerup_time -= elapsed;
 
     /* Update the game state if the player hasn't died yet */
-    if (!is_dead) {
+    if (!w->is_dead) {
         /* Try to execute any buffered or coyote time jumps */
-        try_jump();
+        try_jump(w);
 
         /* Check if fast-fall should be disabled (key timeout) */
-        if (is_fast_falling &&
-            (player.state == STATE_JUMPING || player.state == STATE_FALLING)) {
+        if (w->is_fast_falling && (w->player.state == STATE_JUMPING ||
+                                   w->player.state == STATE_FALLING)) {
             /* Stop fast-falling if key hasn't been pressed recently */
-            if (TICKCOUNT - last_fast_fall_time > 50) /* 50ms timeout */
-                is_fast_falling = false;
+            if (clock_since(w, w->last_fast_fall_time) >
+                50 * NS_PER_MS) /* 50ms timeout */
+                w->is_fast_falling = false;
         }
 
         /* Check if the player is still pressing the key to duck */
-        if (player.state == STATE_DUCK) {
+        if (w->player.state == STATE_DUCK) {
             /* If still pressing, set state as ducking, otherwise as running */
-            if (TICKCOUNT - last_key_check_time < cfg->powerups.duck_timeout) {
-                player.state = STATE_DUCK;
-                can_throw_fireball = false;
+            if (clock_since(w, w->last_key_check_time) <
+                cfg->powerups.duck_timeout * NS_PER_MS) {
+                w->player.state = STATE_DUCK;
+                w->can_throw_fireball = false;
             } else {
-                player.state = STATE_RUNNING;
-                can_throw_fireball = true;
+                w->player.state = STATE_RUNNING;
+                w->can_throw_fireball = true;
             }
         }
 
         /* Generate obstacles randomly */
-        if (f_time_random >= obstacle_time) {
-            object_type_t object_type =
-                play_random_object(powerup_time > 0.0f ? false : true);
-            play_add_object(RESOLUTION_COLS, RESOLUTION_ROWS - 5, object_type);
-
-            const level_config_t *level = config_get_level(current_level + 1);
-            obstacle_time = level->spawn_min +
-                            (random() % (level->spawn_max - level->spawn_min));
-            f_time_random = 0.0f;
+        if (w->f_time_random >= spawn_slot(w, 0)->delay) {
+            play_add_object(w, w->cols, w->rows - 5, spawn_plan_pop(w));
+            w->f_time_random = 0.0f;
         }
 
         /* Check if 10MS have passed since the last Update */
-        if (f_time_10ms >= cfg->timing.update_ms) {
+        if (w->f_time_10ms >= cfg->timing.update_ms) {
             /* If it has passed, reset the variable that stores the total time
              */
-            f_time_10ms = 0.0f;
+            w->f_time_10ms = 0.0f;
 
             /* Update the player object according to the animation, jumping or
                falling */
-            if (player.state == STATE_JUMPING) {
-                player.height += 1;
+            if (w->player.state == STATE_JUMPING) {
+                w->player.height += w->scale;
 
                 /* If reached maximum height, make him fall */
-                if (player.height > cfg->physics.jump_height)
-                    player.state = STATE_FALLING;
-            } else if (player.state == STATE_FALLING) {
+                if (w->player.height > cfg->physics.jump_height * w->scale)
+                    w->player.state = STATE_FALLING;
+            } else if (w->player.state == STATE_FALLING) {
                 /* Apply fast-fall multiplier if holding down */
-                player.height -=
-                    is_fast_falling ? (int) fast_fall_multiplier : 1;
+                w->player.height -=
+                    (w->is_fast_falling ? (int) w->fast_fall_multiplier : 1) *
+                    w->scale;
 
                 /* If reached the ground, change to running animation and reset
                  * variables
                  */
-                if (player.height <= 0 && !is_falling_animation) {
-                    player.state = STATE_RUNNING;
-                    player.frame = 0;
-                    player.height = 0;
-                    is_fast_falling = false; /* Reset fast-fall on landing */
-                } else if (is_falling_animation &&
-                           player.height <
-                               cfg->physics.fall_depth - player.rows)
-                    play_kill_player();
+                if (w->player.height <= 0 && !w->is_falling_animation) {
+                    w->player.state = STATE_RUNNING;
+                    w->player.frame = 0;
+                    w->player.height = 0;
+                    w->is_fast_falling = false; /* Reset fast-fall on landing */
+                } else if (w->is_falling_animation &&
+                           w->player.height <
+                               cfg->physics.fall_depth * w->scale -
+                                   w->player.rows)
+                    play_kill_player(w);
             }
 
-            if (!is_falling_animation) {
-                /* Increment the distance traveled */
-                distance += current_level > 7 ? 2 : 1;
+            if (!w->is_falling_animation) {
+                /* Scroll by the whole cells the speed adds up to */
+                w->scroll_frac += scroll_speed(w);
+                w->scroll_step = w->scroll_frac / SPEED_ONE;
+                w->scroll_frac %= SPEED_ONE;
+                w->distance += w->scroll_step;
 
                 /* Clear spatial hash for this frame */
-                spatial_clear();
+                TRACE_BEGIN("move");
+                spatial_clear(w);
 
                 /* Update other game objects besides the player */
-                int speed = current_level > 7 ? 2 : 1;
+                int speed = w->scroll_step;
                 object_t *object;
-                FOR_EACH_OBJECT (object) {
+                FOR_EACH_OBJECT (w, object) {
                     /* Skip invalid objects */
                     if (object_is_invalid(object))
                         continue;
@@ -1079,14 +1545,16 @@ void play_update_world(double elapsed)
                         (object->type == OBJECT_FIRE_BALL) ? speed : -speed;
 
                     /* Add object to spatial hash for collision detection */
-                    spatial_add_object(object);
+                    spatial_add_object(w, object);
                 }
 
                 /* Add player to spatial hash */
-                spatial_add_object(&player);
+                spatial_add_object(w, &w->player);
+                TRACE_END("move");
 
                 /* Perform collision detection using spatial queries */
-                FOR_EACH_OBJECT (object) {
+                TRACE_BEGIN("collide");
+                FOR_EACH_OBJECT (w, object) {
                     /* Skip invalid objects */
                     if (object_is_invalid(object))
                         continue;
@@ -1096,235 +1564,353 @@ void play_update_world(double elapsed)
                     if (object->type == OBJECT_FIRE_BALL) {
                         /* Fireballs seek targets using spatial hash
                          * optimization */
-                        object_t *target = find_closest_target(object);
+                        object_t *target = find_closest_target(w, object);
                         if (target && !object_is_invalid(target))
-                            spatial_collision_check_pair(object, target);
+                            spatial_collision_check_pair(w, object, target);
                     } else {
                         /* All other objects check collision with player */
-                        spatial_collision_check_pair(object, &player);
+                        spatial_collision_check_pair(w, object, &w->player);
                     }
                 }
 
+                TRACE_END("collide");
+
                 /* Track if player is airborne this frame */
-                bool is_airborne = (player.state == STATE_JUMPING ||
-                                    player.state == STATE_FALLING);
+                bool is_airborne = (w->player.state == STATE_JUMPING ||
+                                    w->player.state == STATE_FALLING);
+
+                /* An update may scroll further than the usual window, the
+                 * window must still catch every obstacle on its way past
+                 */
+                int pass_window = 2 * w->scale > w->scroll_step
+                                      ? 2 * w->scale
+                                      : w->scroll_step;
 
                 /* Process objects for scoring and cleanup */
-                FOR_EACH_OBJECT (object) {
+                TRACE_BEGIN("score");
+                FOR_EACH_OBJECT (w, object) {
                     /* Skip invalid objects */
                     if (object_is_invalid(object))
                         continue;
 
                     /* Check if enemy obstacle just cleared the player */
-                    bool just_passed = object->enemy &&
-                                       object->x + object->cols < player.x &&
-                                       object->x + object->cols >= player.x - 2;
+                    bool just_passed =
+                        object->enemy &&
+                        object->x + object->cols < w->player.x &&
+                        object->x + object->cols >= w->player.x - pass_window;
 
                     if (just_passed && is_airborne) {
                         /* Player cleared obstacle while airborne */
-                        cleared_obstacle_while_airborne = true;
+                        w->cleared_obstacle_while_airborne = true;
 
                         /* Award streak bonus points */
-                        if (aerial_streak > 0) {
-                            int multiplier = aerial_streak + 1;
-                            user_score += 10 * multiplier;
+                        if (w->aerial_streak > 0) {
+                            int multiplier = w->aerial_streak + 1;
+                            w->user_score += 10 * multiplier;
                         }
                     }
 
                     /* Mark objects that left the screen as invalid */
                     bool off_screen = object->x + object->cols < 0 ||
                                       (object->type == OBJECT_FIRE_BALL &&
-                                       object->x > RESOLUTION_COLS);
+                                       object->x > w->cols);
 
                     if (off_screen) {
                         object->x = INVALID_X_SENTINEL; /* Mark invalid */
 
                         const level_config_t *level =
-                            config_get_level(current_level + 1);
-                        user_score += level->level;
+                            config_get_level(w->current_level + 1);
+                        w->user_score += level->level;
                     }
                 }
 
                 /* Clean up invalid objects from ring buffer */
-                ring_buffer_cleanup_invalid(&objects_ring);
+                ring_buffer_cleanup_invalid(&w->objects);
+                TRACE_END("score");
 
                 /* Update streak based on landing/airborne state */
-                if (was_airborne_last_frame && !is_airborne) {
+                if (w->was_airborne_last_frame && !is_airborne) {
                     /* Just landed */
-                    if (cleared_obstacle_while_airborne) {
+                    if (w->cleared_obstacle_while_airborne) {
                         /* Successfully cleared obstacle(s) while airborne */
-                        aerial_streak++;
-                        if (aerial_streak > max_streak)
-                            max_streak = aerial_streak;
-                        cleared_obstacle_while_airborne = false;
-                    } else if (aerial_streak > 0) {
+                        w->aerial_streak++;
+                        if (w->aerial_streak > w->max_streak)
+                            w->max_streak = w->aerial_streak;
+                        w->cleared_obstacle_while_airborne = false;
+                    } else if (w->aerial_streak > 0) {
                         /* Landed without clearing an obstacle - reset streak */
-                        aerial_streak = 0;
+                        w->aerial_streak = 0;
                     }
                 }
 
-                was_airborne_last_frame = is_airborne;
+                w->was_airborne_last_frame = is_airborne;
             }
         }
 
         /* Check if 150MS have passed since the last Update */
-        if (f_time_150ms > cfg->timing.anim_ms) {
-            f_time_150ms = 0.0f;
+        if (w->f_time_150ms > cfg->timing.anim_ms) {
+            w->f_time_150ms = 0.0f;
 
             /* Update the dinosaur animation frame (0..2) */
-            player.frame = (player.frame + 1) % player.max_frames;
+            w->player.frame = (w->player.frame + 1) % w->player.max_frames;
 
             /* Update other game objects besides the player */
+            TRACE_BEGIN("animate");
             object_t *obj;
-            FOR_EACH_OBJECT (obj) {
+            FOR_EACH_OBJECT (w, obj) {
                 if (!object_is_invalid(obj)) /* Valid object */
                     obj->frame = (obj->frame + 1) % obj->max_frames;
             }
+            TRACE_END("animate");
 
             /* Update the User Score */
-            user_score += cfg->scoring.per_frame;
+            w->user_score += cfg->scoring.per_frame;
 
             /* Update the level if it meets the condition */
-            const level_config_t *level = config_get_level(current_level + 1);
-            if (user_score >= level->score_next &&
-                current_level != cfg->limits.max_level - 1) {
-                current_level++;
+            const level_config_t *level =
+                config_get_level(w->current_level + 1);
+            if (w->user_score >= level->score_next &&
+                w->current_level != cfg->limits.max_level - 1) {
+                w->current_level++;
+                spawn_plan_retime(w);
+                PROBE2(level, w->current_level, w->user_score);
             }
         }
     }
 }
 
-void play_render_world()
+/* Civil date of @secs since the epoch, without the time zone lookup that
+ * gmtime() may do on first use
+ */
+static void epoch_date(int64_t secs, int *year, int *month, int *day)
+{
+    int64_t days = secs / 86400 + 719468;
+    int64_t era = days / 146097;
+    int doe = (int) (days - era * 146097);
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+
+    *day = doy - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = (int) (era * 400 + yoe) + (*month <= 2);
+}
+
+/* High scores of all sessions below the death message, as many as fit */
+static void render_board(const world_t *w, int top)
+{
+    board_entry_t entries[BOARD_SLOTS];
+    int count = board_read(entries);
+    int room = w->rows - 5 - (top + 2); /* Title and a blank line first */
+    if (count > room)
+        count = room;
+    if (count <= 0)
+        return;
+
+    static const char title[] = "High Scores";
+    draw_text_color((w->cols >> 1) - (int) (sizeof(title) - 1) / 2, top,
+                    (char *) title, TUI_A_BOLD, 255, 215, 0);
+
+    for (int i = 0; i < count; i++) {
+        int year, month, day;
+        epoch_date(entries[i].when, &year, &month, &day);
+
+        char line[64];
+        int len = snprintf(line, sizeof(line), "%2d. %7d  %04d-%02d-%02d%s",
+                           i + 1, entries[i].score, year, month, day,
+                           entries[i].mine ? " <" : "  ");
+        if (entries[i].mine)
+            draw_text_color((w->cols >> 1) - (len >> 1), top + 2 + i, line,
+                            TUI_A_BOLD, 255, 215, 0);
+        else
+            draw_text_color((w->cols >> 1) - (len >> 1), top + 2 + i, line,
+                            0, 200, 200, 200);
+    }
+}
+
+void play_world_render(const world_t *w)
 {
     const game_config_t *cfg = ensure_cfg();
 
     /* Draw ground layers */
-    const rgb_color_t *primary = is_dead ? &cfg->colors.ground_dead_primary
-                                         : &cfg->colors.ground_normal_primary;
-    const rgb_color_t *secondary = is_dead
+    const rgb_color_t *primary = w->is_dead
+                                     ? &cfg->colors.ground_dead_primary
+                                     : &cfg->colors.ground_normal_primary;
+    const rgb_color_t *secondary = w->is_dead
                                        ? &cfg->colors.ground_dead_secondary
                                        : &cfg->colors.ground_normal_secondary;
 
-    draw_block_color(0, RESOLUTION_ROWS - 5, RESOLUTION_COLS, 1, primary->r,
-                     primary->g, primary->b);
-    draw_block_color(0, RESOLUTION_ROWS - 4, RESOLUTION_COLS, 3, secondary->r,
-                     secondary->g, secondary->b);
-    draw_block_color(0, RESOLUTION_ROWS - 1, RESOLUTION_COLS, 1, 0, 0, 0);
+    draw_block_color(0, w->rows - 5, w->cols, 1, primary->r, primary->g,
+                     primary->b);
+    draw_block_color(0, w->rows - 4, w->cols, 3, secondary->r, secondary->g,
+                     secondary->b);
+    draw_block_color(0, w->rows - 1, w->cols, 1, 0, 0, 0);
 
     /* Draw specks */
-    const rgb_color_t *speck =
-        is_dead ? &cfg->colors.ground_dead_primary : &cfg->colors.ground_speck;
-    for (int i = 0; i < RESOLUTION_COLS; ++i) {
-        if (((distance + i) % cfg->render.speck_interval_1) == 0)
-            draw_text_bg(i, RESOLUTION_ROWS - 4, "_", TUI_A_BOLD, speck->r,
-                         speck->g, speck->b, secondary->r, secondary->g,
-                         secondary->b);
-
-        if (((distance + i) % cfg->render.speck_interval_2) == 0)
-            draw_text_bg(i, RESOLUTION_ROWS - 3, ".", TUI_A_BOLD, speck->r,
-                         speck->g, speck->b, secondary->r, secondary->g,
-                         secondary->b);
+    const rgb_color_t *speck = w->is_dead ? &cfg->colors.ground_dead_primary
+                                          : &cfg->colors.ground_speck;
+    for (int i = 0; i < w->cols; ++i) {
+        if (((w->distance + i) % cfg->render.speck_interval_1) == 0)
+            draw_text_bg(i, w->rows - 4, "_", TUI_A_BOLD, speck->r, speck->g,
+                         speck->b, secondary->r, secondary->g, secondary->b);
+
+        if (((w->distance + i) % cfg->render.speck_interval_2) == 0)
+            draw_text_bg(i, w->rows - 3, ".", TUI_A_BOLD, speck->r, speck->g,
+                         speck->b, secondary->r, secondary->g, secondary->b);
     }
 
     /* Draw other game objects */
-    object_t *object;
-    FOR_EACH_OBJECT (object) {
+    const object_t *object;
+    FOR_EACH_OBJECT (w, object) {
         /* Skip invalid objects */
         if (!object_is_invalid(object)) /* Valid object */
-            play_render_object(object);
+            play_render_object(w, object);
     }
 
     /* Draw the player (T-Rex dinosaur) */
-    play_render_object(&player);
+    play_render_object(w, &w->player);
 
     /* Draw screen when the player died */
-    if (is_dead) {
+    if (w->is_dead) {
         static const char *death_text = "Failed";
         static const int death_text_len = 9;
-        draw_text_color((RESOLUTION_COLS >> 1) - (death_text_len >> 1),
-                        (RESOLUTION_ROWS >> 1) - 5, (char *) death_text,
-                        TUI_A_BOLD, 255, 70, 70);
+        draw_text_color((w->cols >> 1) - (death_text_len >> 1),
+                        (w->rows >> 1) - 5, (char *) death_text, TUI_A_BOLD,
+                        255, 70, 70);
 
         char sz_user_score[32] = {0};
         int score_len = snprintf(sz_user_score, sizeof(sz_user_score),
-                                 "Final Score: %d", user_score);
-        draw_text_color((RESOLUTION_COLS >> 1) - (score_len >> 1),
-                        (RESOLUTION_ROWS >> 1) - 4, sz_user_score, 0, 255, 255,
-                        255);
+                                 "Final Score: %d", w->user_score);
+        draw_text_color((w->cols >> 1) - (score_len >> 1), (w->rows >> 1) - 4,
+                        sz_user_score, 0, 255, 255, 255);
 
         static const char *restart_text = "Press SPACE to restart!";
         static const int restart_text_len =
             23; /* Cache strlen("Press SPACE to restart!") */
-        draw_text_color((RESOLUTION_COLS >> 1) - (restart_text_len >> 1),
-                        (RESOLUTION_ROWS >> 1) - 2, (char *) restart_text, 0,
-                        255, 255, 255);
+        draw_text_color((w->cols >> 1) - (restart_text_len >> 1),
+                        (w->rows >> 1) - 2, (char *) restart_text, 0, 255, 255,
+                        255);
+
+        render_board(w, w->rows >> 1);
     } else {
         /* Draw the player's user score */
-        draw_text_color(RESOLUTION_COLS - 20, 2, "User Score", 0, 255, 255,
-                        255);
+        draw_text_color(w->cols - 20, 2, "User Score", 0, 255, 255, 255);
 
         char sz_text[128] = {0};
-        snprintf(sz_text, sizeof(sz_text), "%d", user_score);
-        draw_text_color(RESOLUTION_COLS - 8, 2, sz_text, TUI_A_BOLD, 0, 255, 0);
+        snprintf(sz_text, sizeof(sz_text), "%d", w->user_score);
+        draw_text_color(w->cols - 8, 2, sz_text, TUI_A_BOLD, 0, 255, 0);
 
         /* Draw streak counter if active */
-        if (aerial_streak > 0) {
+        if (w->aerial_streak > 0) {
             snprintf(sz_text, sizeof(sz_text), "Streak: %dx",
-                     aerial_streak + 1);
+                     w->aerial_streak + 1);
             /* Gold color for streak */
-            draw_text_color(RESOLUTION_COLS - 20, 4, sz_text, TUI_A_BOLD, 255,
-                            215, 0);
+            draw_text_color(w->cols - 20, 4, sz_text, TUI_A_BOLD, 255, 215, 0);
         }
 
         /* Draw max streak */
-        if (max_streak > 0) {
-            snprintf(sz_text, sizeof(sz_text), "Max: %dx", max_streak + 1);
+        if (w->max_streak > 0) {
+            snprintf(sz_text, sizeof(sz_text), "Max: %dx", w->max_streak + 1);
             /* Gray for max streak */
-            draw_text_color(RESOLUTION_COLS - 20, 5, sz_text, 0, 200, 200, 200);
+            draw_text_color(w->cols - 20, 5, sz_text, 0, 200, 200, 200);
         }
 
-        int level_len =
-            snprintf(sz_text, sizeof(sz_text), "LEVEL %d", current_level + 1);
-        draw_text_color((RESOLUTION_COLS >> 1) - (level_len >> 1), 2, sz_text,
+        int level_len = snprintf(sz_text, sizeof(sz_text), "LEVEL %d",
+                                 w->current_level + 1);
+        draw_text_color((w->cols >> 1) - (level_len >> 1), 2, sz_text,
                         TUI_A_BOLD, 255, 255, 255);
     }
 }
 
-void play_handle_input(int key_code)
+void play_world_handle_input(world_t *w, int key_code)
 {
-    if (!is_dead && !is_falling_animation) {
+    if (!w->is_dead && !w->is_falling_animation) {
         switch (key_code) {
         case ' ':
         case TUI_KEY_UP:
             /* Record jump input for buffering */
-            on_keydown_jump();
+            on_keydown_jump(w);
             break;
         case TUI_KEY_DOWN:
             /* Check if the player can throw fireball */
-            if (can_throw_fireball && powerup_time > 0.0f &&
-                powerup_type == OBJECT_EGG_FIRE)
-                play_add_object(player.x + 5, player.y + 10, OBJECT_FIRE_BALL);
+            if (w->can_throw_fireball && w->powerup_time > 0.0f &&
+                w->powerup_type == OBJECT_EGG_FIRE)
+                play_add_object(w, w->player.x + 5 * w->scale,
+                                w->player.y + 10 * w->scale,
+                                OBJECT_FIRE_BALL);
 
             /* Handle fast-fall when airborne, or duck when grounded */
-            if (player.state == STATE_JUMPING ||
-                player.state == STATE_FALLING) {
+            if (w->player.state == STATE_JUMPING ||
+                w->player.state == STATE_FALLING) {
                 /* Enable fast-fall when down is pressed while airborne */
-                is_fast_falling = true;
-                last_fast_fall_time = TICKCOUNT;
-                if (player.state == STATE_JUMPING) {
+                w->is_fast_falling = true;
+                w->last_fast_fall_time = w->clock_ns;
+                if (w->player.state == STATE_JUMPING) {
                     /* Immediately transition to falling if jumping */
-                    player.state = STATE_FALLING;
+                    w->player.state = STATE_FALLING;
                 }
             } else {
                 /* Duck when on ground */
-                last_key_check_time = TICKCOUNT;
-                player.state = STATE_DUCK;
+                w->last_key_check_time = w->clock_ns;
+                w->player.state = STATE_DUCK;
             }
             break;
         default:
             break;
         }
-    } else if (is_dead &&
+    } else if (w->is_dead &&
                (key_code == ' ' || key_code == 10 || key_code == TUI_KEY_ENTER))
-        play_init_world();
+        play_world_reset(w);
+}
+
+/* Check whether two rectangles share any row */
+static inline bool rows_overlap(const bounding_rect_t *rect1,
+                                const bounding_rect_t *rect2)
+{
+    return !(rect1->top >= rect2->bottom || rect2->top >= rect1->bottom);
+}
+
+/**
+ * Pick the key a simple autoplayer would press in this frame
+ * @w : World to look at
+ *
+ * Looks at the nearest enemy ahead of the player and ducks under it when that
+ * is enough, otherwise jumps once it is close. Return the key code to feed to
+ * play_world_handle_input(), or -1 to do nothing.
+ */
+int play_world_bot_input(const world_t *w)
+{
+    if (w->is_dead || w->is_falling_animation || !is_player_on_ground(w))
+        return -1;
+
+    object_t stand = w->player, duck = w->player;
+    stand.state = STATE_RUNNING;
+    duck.state = STATE_DUCK;
+    bounding_rect_t stand_bounds = get_bounds(w, &stand, true);
+    bounding_rect_t duck_bounds = get_bounds(w, &duck, true);
+
+    /* Nearest enemy that has not passed the player yet */
+    const object_t *next = NULL;
+    const object_t *obj;
+    FOR_EACH_OBJECT (w, obj) {
+        if (object_is_invalid(obj) || !obj->enemy)
+            continue;
+        bounding_rect_t bounds = get_bounds(w, obj, false);
+        if (bounds.right <= stand_bounds.left)
+            continue;
+        if (!next || obj->x < next->x)
+            next = obj;
+    }
+    if (!next)
+        return -1;
+
+    bounding_rect_t enemy = get_bounds(w, next, false);
+    int gap = enemy.left - stand_bounds.right;
+    int lead = (8 * scroll_speed(w) + SPEED_ONE / 2) / SPEED_ONE;
+
+    if (!rows_overlap(&stand_bounds, &enemy))
+        return -1;
+    if (!rows_overlap(&duck_bounds, &enemy))
+        return (gap <= 2 * lead) ? TUI_KEY_DOWN : -1;
+    return (gap <= lead) ? ' ' : -1;
 }
@@ -19,10 +19,27 @@ void menu_render();
 void menu_handle_input(int input);
 void menu_handle_selection(menu_id_t menu);
 
+/* Sprites are drawn at 1x to SPRITE_SCALE_MAX times their size, depending
+ * on the terminal size, see world_scale() in play.c
+ */
+#define SPRITE_SCALE_MAX 3
+#define SPRITE_RUNS_MAX 32
+
+/* Horizontal run of set pixels, in cells of the scaled sprite */
+typedef struct {
+    uint8_t x, y, cols, rows;
+} sprite_run_t;
+
+typedef struct {
+    sprite_run_t runs[SPRITE_RUNS_MAX];
+    int count;
+} sprite_runs_t;
+
 /* Sprite descriptor structure */
 typedef struct {
     const int *data;
     int rows, cols;
+    sprite_runs_t *scaled; /* Run list per scale, built by sprites_init() */
 } sprite_t;
 
 /* Sprite descriptors */
@@ -33,6 +50,13 @@ extern const sprite_t sprite_pterodactyl;
 extern const sprite_t sprite_trex_normal;
 extern const sprite_t sprite_trex_duck;
 
+/* Runs of a sprite drawn @scale times its size */
+static inline const sprite_runs_t *sprite_runs(const sprite_t *sprite,
+                                               int scale)
+{
+    return &sprite->scaled[scale - 1];
+}
+
 /* Get sprite pixel at position */
 static inline int sprite_get_pixel(const sprite_t *sprite, int row, int col)
 {
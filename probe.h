@@ -0,0 +1,81 @@
+#pragma once
+
+/*
+ * Static tracepoints
+ *
+ * PROBE*() place a single nop in the code and describe it in a SystemTap SDT
+ * note (.note.stapsdt): the probe name, the address of the nop and where each
+ * argument lives at that point, such as "-8@%rax". bpftrace, perf and
+ * SystemTap read the notes straight from the binary and patch the nop with a
+ * breakpoint only while they are attached, so a release build carries the
+ * probes at the cost of the nop and of keeping the arguments in registers.
+ *
+ * This is the layout of <sys/sdt.h>, written out so that no header package
+ * is needed. Arguments are passed as signed 64-bit integers.
+ *
+ *   bpftrace -e 'usdt:./trex:trex:flush { @bytes = hist(arg0); }'
+ *   perf buildid-cache --add ./trex && perf probe sdt_trex:frame_end
+ *
+ * Probes: frame_begin, frame_end(frame), refresh_begin,
+ * refresh_end(dirty cells), flush(bytes, iovecs), spawn(type, x, y),
+ * collision(type, other type, x), level(level, score).
+ */
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__aarch64__)
+
+#define PROBE_STR(x) #x
+
+/* The note refers to this symbol so tools can correct for prelinking */
+#define PROBE_BASE                                                   \
+    ".ifndef _.stapsdt.base\n"                                       \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,"  \
+    "comdat\n"                                                       \
+    ".weak _.stapsdt.base\n"                                         \
+    ".hidden _.stapsdt.base\n"                                       \
+    "_.stapsdt.base: .space 1\n"                                     \
+    ".size _.stapsdt.base, 1\n"                                      \
+    ".popsection\n"                                                  \
+    ".endif\n"
+
+#define PROBE_ASM(name, args, ...)                                   \
+    __asm__ __volatile__("990: nop\n"                                \
+                         ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+                         ".balign 4\n"                               \
+                         ".4byte 992f-991f, 994f-993f, 3\n"          \
+                         "991: .asciz \"stapsdt\"\n"                 \
+                         "992: .balign 4\n"                          \
+                         "993: .8byte 990b\n"                        \
+                         ".8byte _.stapsdt.base\n"                   \
+                         ".8byte 0\n"                                \
+                         ".asciz \"trex\"\n"                         \
+                         ".asciz \"" PROBE_STR(name) "\"\n"          \
+                         ".asciz \"" args "\"\n"                     \
+                         "994: .balign 4\n"                          \
+                         ".popsection\n" PROBE_BASE                  \
+                         :                                           \
+                         : __VA_ARGS__)
+
+#define PROBE_ARG(n) "-8@%[a" #n "]"
+
+#define PROBE(name) PROBE_ASM(name, "", )
+#define PROBE1(name, x0) \
+    PROBE_ASM(name, PROBE_ARG(0), [a0] "nor"((int64_t) (x0)))
+#define PROBE2(name, x0, x1)                                        \
+    PROBE_ASM(name, PROBE_ARG(0) " " PROBE_ARG(1),                  \
+              [a0] "nor"((int64_t) (x0)), [a1] "nor"((int64_t) (x1)))
+#define PROBE3(name, x0, x1, x2)                                        \
+    PROBE_ASM(name, PROBE_ARG(0) " " PROBE_ARG(1) " " PROBE_ARG(2),     \
+              [a0] "nor"((int64_t) (x0)), [a1] "nor"((int64_t) (x1)),   \
+              [a2] "nor"((int64_t) (x2)))
+
+#else
+
+/* No note layout for this architecture, the probes compile away */
+#define PROBE(name) ((void) 0)
+#define PROBE1(name, x0) ((void) (x0))
+#define PROBE2(name, x0, x1) ((void) (x0), (void) (x1))
+#define PROBE3(name, x0, x1, x2) ((void) (x0), (void) (x1), (void) (x2))
+
+#endif
@@ -0,0 +1,302 @@
+/*
+ * In-process sampling profiler
+ *
+ * "trex --profile FILE" arms a timer on the process CPU-time clock that
+ * raises SIGPROF PROFILE_HZ times per second of CPU time. The handler
+ * captures a backtrace into a preallocated sample buffer, claiming a slot
+ * with an atomic increment, and tags it with the innermost frame phase of
+ * the interrupted thread (see trace.c). At exit the samples are symbolized
+ * and written as folded stacks, one "phase;outer;...;inner count" line per
+ * distinct stack, which flamegraph.pl and speedscope read directly.
+ *
+ * Functions of the executable, static ones included, are resolved from its
+ * own ELF symbol table, so no external tools are needed on the host. Frames
+ * in shared libraries fall back to dladdr().
+ */
+
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <elf.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trex.h"
+
+#define PROFILE_HZ 499 /* Not a multiple of the frame rate */
+#define PROFILE_MAX_SAMPLES (1 << 15)
+#define PROFILE_MAX_DEPTH 32
+#define PROFILE_SKIP_FRAMES 2 /* The handler and the signal trampoline */
+
+typedef struct {
+    const char *phase;
+    int depth;
+    void *pc[PROFILE_MAX_DEPTH];
+} profile_sample_t;
+
+typedef struct {
+    uintptr_t addr, size;
+    const char *name;
+} profile_symbol_t;
+
+static struct {
+    const char *path;
+    profile_sample_t *samples;
+    unsigned int next; /* Slots claimed, may exceed PROFILE_MAX_SAMPLES */
+    timer_t timer;
+    bool armed;
+
+    /* Symbol table of the executable, loaded at exit */
+    profile_symbol_t *symbols;
+    size_t nsymbols;
+    uintptr_t bias; /* Load address of the executable */
+} prof;
+
+static void profile_handler(int sig)
+{
+    (void) sig;
+    int saved_errno = errno;
+
+    unsigned int slot = __atomic_fetch_add(&prof.next, 1, __ATOMIC_RELAXED);
+    if (slot < PROFILE_MAX_SAMPLES) {
+        profile_sample_t *sample = &prof.samples[slot];
+        void *pc[PROFILE_MAX_DEPTH + PROFILE_SKIP_FRAMES];
+        int depth = backtrace(pc, PROFILE_MAX_DEPTH + PROFILE_SKIP_FRAMES) -
+                    PROFILE_SKIP_FRAMES;
+
+        for (int i = 0; i < depth; i++)
+            sample->pc[i] = pc[i + PROFILE_SKIP_FRAMES];
+        sample->phase = trace_current_phase();
+        sample->depth = depth > 0 ? depth : 0;
+    }
+
+    errno = saved_errno;
+}
+
+static int symbol_cmp(const void *a, const void *b)
+{
+    const profile_symbol_t *sa = a, *sb = b;
+    return (sa->addr > sb->addr) - (sa->addr < sb->addr);
+}
+
+/* Load the function symbols of /proc/self/exe, they stay mapped until exit */
+static void profile_load_symbols(void)
+{
+    int fd = open("/proc/self/exe", O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return;
+
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t) st.st_size >= sizeof(Elf64_Ehdr))
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return;
+
+    const uint8_t *base = map;
+    const Elf64_Ehdr *eh = map;
+    if (memcmp(eh->e_ident, ELFMAG, SELFMAG) ||
+        eh->e_ident[EI_CLASS] != ELFCLASS64 ||
+        eh->e_shoff + (size_t) eh->e_shnum * sizeof(Elf64_Shdr) >
+            (size_t) st.st_size)
+        return;
+
+    const Elf64_Shdr *sh = (const Elf64_Shdr *) (base + eh->e_shoff);
+    for (int i = 0; i < eh->e_shnum; i++) {
+        if (sh[i].sh_type != SHT_SYMTAB || sh[i].sh_link >= eh->e_shnum)
+            continue;
+
+        const Elf64_Shdr *str = &sh[sh[i].sh_link];
+        if (sh[i].sh_offset + sh[i].sh_size > (size_t) st.st_size ||
+            str->sh_offset + str->sh_size > (size_t) st.st_size)
+            break;
+
+        const Elf64_Sym *syms = (const Elf64_Sym *) (base + sh[i].sh_offset);
+        const char *strtab = (const char *) (base + str->sh_offset);
+        size_t count = sh[i].sh_size / sizeof(Elf64_Sym);
+
+        prof.symbols = calloc(count, sizeof(profile_symbol_t));
+        if (!prof.symbols)
+            return;
+
+        for (size_t j = 0; j < count; j++) {
+            if (ELF64_ST_TYPE(syms[j].st_info) != STT_FUNC ||
+                !syms[j].st_value || syms[j].st_name >= str->sh_size)
+                continue;
+
+            profile_symbol_t *sym = &prof.symbols[prof.nsymbols++];
+            sym->addr = syms[j].st_value;
+            sym->size = syms[j].st_size;
+            sym->name = strtab + syms[j].st_name;
+
+            /* Any known function gives the load bias of a PIE */
+            if (!strcmp(sym->name, "profile_open"))
+                prof.bias = (uintptr_t) profile_open - sym->addr;
+        }
+        break;
+    }
+
+    qsort(prof.symbols, prof.nsymbols, sizeof(profile_symbol_t), symbol_cmp);
+}
+
+static const char *profile_symbolize(void *pc)
+{
+    uintptr_t addr = (uintptr_t) pc - prof.bias;
+    size_t lo = 0, hi = prof.nsymbols;
+
+    /* Last symbol starting at or below addr */
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (prof.symbols[mid].addr <= addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo > 0) {
+        const profile_symbol_t *sym = &prof.symbols[lo - 1];
+        if (addr < sym->addr + sym->size)
+            return sym->name;
+    }
+
+    Dl_info info;
+    if (dladdr(pc, &info)) {
+        if (info.dli_sname)
+            return info.dli_sname;
+        if (info.dli_fname) {
+            const char *slash = strrchr(info.dli_fname, '/');
+            return slash ? slash + 1 : info.dli_fname;
+        }
+    }
+    return "[unknown]";
+}
+
+/* Render a sample as "phase;outer;...;inner" */
+static char *profile_fold(const profile_sample_t *sample)
+{
+    char buf[4096];
+    size_t len = snprintf(buf, sizeof(buf), "%s",
+                          sample->phase ? sample->phase : "other");
+
+    for (int i = sample->depth - 1; i >= 0 && len < sizeof(buf); i--) {
+        /* Return addresses point past the call, except the interrupted pc */
+        void *pc = (char *) sample->pc[i] - (i ? 1 : 0);
+        len += snprintf(buf + len, sizeof(buf) - len, ";%s",
+                        profile_symbolize(pc));
+    }
+
+    return strdup(buf);
+}
+
+static int fold_cmp(const void *a, const void *b)
+{
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+/* Stop sampling and write the folded stacks, also registered with atexit() */
+void profile_close(void)
+{
+    if (!prof.armed)
+        return;
+    prof.armed = false;
+
+    timer_delete(prof.timer);
+    signal(SIGPROF, SIG_IGN);
+
+    unsigned int count = prof.next < PROFILE_MAX_SAMPLES ? prof.next
+                                                         : PROFILE_MAX_SAMPLES;
+    char **folded = calloc(count ? count : 1, sizeof(char *));
+    FILE *out = fopen(prof.path, "w");
+    if (!folded || !out) {
+        if (!out)
+            perror(prof.path);
+        else
+            fclose(out);
+        free(folded);
+        return;
+    }
+
+    profile_load_symbols();
+
+    unsigned int nfolded = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        char *line = profile_fold(&prof.samples[i]);
+        if (line)
+            folded[nfolded++] = line;
+    }
+
+    /* Identical stacks end up next to each other */
+    qsort(folded, nfolded, sizeof(char *), fold_cmp);
+    for (unsigned int i = 0; i < nfolded;) {
+        unsigned int j = i + 1;
+        while (j < nfolded && !strcmp(folded[i], folded[j]))
+            j++;
+        fprintf(out, "%s %u\n", folded[i], j - i);
+        i = j;
+    }
+    if (prof.next > PROFILE_MAX_SAMPLES)
+        fprintf(out, "[dropped] %u\n", prof.next - PROFILE_MAX_SAMPLES);
+    fclose(out);
+
+    for (unsigned int i = 0; i < nfolded; i++)
+        free(folded[i]);
+    free(folded);
+}
+
+/**
+ * Start sampling the process CPU time
+ * @path : File the folded stacks are written to at exit
+ *
+ * Returns false if the profiler could not be set up.
+ */
+bool profile_open(const char *path)
+{
+    prof.path = path;
+    prof.samples = calloc(PROFILE_MAX_SAMPLES, sizeof(profile_sample_t));
+    if (!prof.samples)
+        return false;
+
+    /* The first backtrace() loads the unwinder, keep that out of the handler
+     */
+    void *warmup[1];
+    backtrace(warmup, 1);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = profile_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, NULL) == -1)
+        return false;
+
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = SIGPROF;
+    if (timer_create(CLOCK_PROCESS_CPUTIME_ID, &sev, &prof.timer) == -1)
+        return false;
+
+    struct itimerspec its = {
+        .it_interval = {.tv_nsec = 1000000000L / PROFILE_HZ},
+        .it_value = {.tv_nsec = 1000000000L / PROFILE_HZ},
+    };
+    if (timer_settime(prof.timer, 0, &its, NULL) == -1) {
+        timer_delete(prof.timer);
+        return false;
+    }
+
+    trace_track_phases();
+    prof.armed = true;
+    atexit(profile_close);
+    return true;
+}
@@ -0,0 +1,267 @@
+/*
+ * Frame scheduler for busy hosts
+ *
+ * The game loop ticks at the configured frame rate and every tick advances
+ * the simulation by one fixed step. Only every divisor-th tick is rendered:
+ * when ticks keep missing their deadline or the cgroup of the process gets
+ * throttled, the render rate steps down from 60 to 30 to 20 fps so that the
+ * simulation keeps its pace with the CPU that is left. It steps back up once
+ * a few windows in a row were clean and the measured cost of a tick leaves
+ * room for the extra renders.
+ *
+ * Decisions are taken once per SCHED_WINDOW_MS. The cgroup counters are read
+ * with a single pread() at that point, nothing is done per tick beyond a few
+ * additions.
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "trex.h"
+
+#define SCHED_WINDOW_MS 1000.0
+#define SCHED_MISS_RATIO 0.1   /* Missed ticks in a window that step down */
+#define SCHED_RESTORE_WINDOWS 3 /* Clean windows before stepping up */
+#define SCHED_HEADROOM 0.5      /* Busy share of a tick that allows it */
+#define SCHED_BACKLOG_MAX 4     /* Late ticks caught up before dropping */
+
+/* Ticks per rendered frame: 60, 30 and 20 fps at the default tick rate */
+static const int render_divisors[] = {1, 2, 3};
+#define SCHED_LEVELS ((int) (sizeof(render_divisors) / sizeof(int)))
+
+static struct {
+    bool enabled;
+    double tick_ms;
+    int level; /* Index into render_divisors */
+    int since_render;
+    bool late; /* The current tick started after the next one was due */
+
+    /* Current window */
+    double window_start;
+    int ticks, misses, renders;
+    double update_ms, render_ms;
+    int clean_windows;
+
+    /* cpu.stat of the cgroup, -1 if there is none */
+    int cpu_stat_fd;
+    uint64_t nr_throttled;
+
+    sched_stats_t stats;
+} sched = {.cpu_stat_fd = -1};
+
+/**
+ * Read the throttling counters of a cgroup
+ * @fd : Open cpu.stat
+ * @nr_throttled : Periods in which the quota ran out
+ *
+ * Returns false if the file has no throttling counters.
+ */
+static bool read_cpu_stat(int fd, uint64_t *nr_throttled)
+{
+    char buf[1024];
+    ssize_t len = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (len <= 0)
+        return false;
+    buf[len] = '\0';
+
+    const char *key = strstr(buf, "nr_throttled ");
+    if (!key)
+        return false;
+    *nr_throttled = strtoull(key + strlen("nr_throttled "), NULL, 10);
+    return true;
+}
+
+/* Whether the comma separated @list names controller @name */
+static bool has_controller(const char *list, const char *name)
+{
+    size_t len = strlen(name);
+    for (const char *p = list; p; p = strchr(p, ',')) {
+        if (*p == ',')
+            p++;
+        if (!strncmp(p, name, len) && (p[len] == ',' || !p[len]))
+            return true;
+    }
+    return false;
+}
+
+/* Open cpu.stat of the cgroup v2, or v1 cpu controller, this process is in */
+static int open_cpu_stat(void)
+{
+    FILE *f = fopen("/proc/self/cgroup", "re");
+    if (!f)
+        return -1;
+
+    char line[PATH_MAX], path[PATH_MAX + 64];
+    int fd = -1;
+    while (fd == -1 && fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\n")] = '\0';
+
+        /* "0::/path" on v2, "4:cpu,cpuacct:/path" on v1 */
+        char *controllers = strchr(line, ':');
+        char *group = controllers ? strchr(controllers + 1, ':') : NULL;
+        if (!group)
+            continue;
+        *group++ = '\0';
+        controllers++;
+
+        if (!*controllers)
+            snprintf(path, sizeof(path), "/sys/fs/cgroup%s/cpu.stat", group);
+        else if (has_controller(controllers, "cpu"))
+            snprintf(path, sizeof(path), "/sys/fs/cgroup/%s%s/cpu.stat",
+                     controllers, group);
+        else
+            continue;
+
+        /* The v2 file lacks the counters while the controller is off */
+        uint64_t nr;
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd != -1 && !read_cpu_stat(fd, &nr)) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    fclose(f);
+    return fd;
+}
+
+/**
+ * Start scheduling the game loop
+ * @tick_ms : Simulation step, also the interval of full-rate rendering
+ */
+void sched_open(double tick_ms)
+{
+    sched.enabled = true;
+    sched.tick_ms = tick_ms;
+    sched.window_start = state_get_time_ms();
+
+    sched.cpu_stat_fd = open_cpu_stat();
+    if (sched.cpu_stat_fd != -1)
+        read_cpu_stat(sched.cpu_stat_fd, &sched.nr_throttled);
+}
+
+void sched_close(void)
+{
+    if (sched.cpu_stat_fd != -1)
+        close(sched.cpu_stat_fd);
+    sched.cpu_stat_fd = -1;
+    sched.enabled = false;
+}
+
+/**
+ * Begin a tick of the game loop
+ * @backlog_ms : Time owed to the simulation, at least one tick
+ *
+ * A backlog of more than SCHED_BACKLOG_MAX ticks is dropped down to this one,
+ * the simulation slows down instead of racing through it.
+ *
+ * Returns true if this tick should be rendered.
+ */
+bool sched_begin_tick(double *backlog_ms)
+{
+    if (*backlog_ms > SCHED_BACKLOG_MAX * sched.tick_ms) {
+        sched.stats.dropped_ticks +=
+            (uint64_t) (*backlog_ms / sched.tick_ms) - 1;
+        *backlog_ms = sched.tick_ms;
+    }
+
+    /* Another tick is already due, leave the render to the last one */
+    bool late = *backlog_ms >= 2 * sched.tick_ms;
+    sched.late = late;
+
+    int divisor = render_divisors[sched.level];
+    if (++sched.since_render < divisor)
+        return false;
+    if (late && sched.since_render < divisor + SCHED_BACKLOG_MAX)
+        return false;
+
+    sched.since_render = 0;
+    return true;
+}
+
+/* Render rate at @level, whole frames per second */
+static int level_fps(int level)
+{
+    return (int) (1000.0 / (sched.tick_ms * render_divisors[level]) + 0.5);
+}
+
+/* Step the render rate by the misses, throttling and cost of a window */
+static void sched_decide(void)
+{
+    bool throttled = false;
+    uint64_t nr;
+    if (sched.cpu_stat_fd != -1 && read_cpu_stat(sched.cpu_stat_fd, &nr)) {
+        throttled = nr > sched.nr_throttled;
+        sched.nr_throttled = nr;
+    }
+    if (throttled)
+        sched.stats.throttled_windows++;
+
+    bool missing = sched.misses > SCHED_MISS_RATIO * sched.ticks;
+    if ((missing || throttled) && sched.level < SCHED_LEVELS - 1) {
+        sched.level++;
+        sched.clean_windows = 0;
+        return;
+    }
+    if (sched.misses || throttled || !sched.level || !sched.renders) {
+        sched.clean_windows = 0;
+        return;
+    }
+
+    /* Cost of a tick with the renders of the next level up */
+    double per_render = sched.render_ms / sched.renders;
+    double projected = sched.update_ms / sched.ticks +
+                       per_render / render_divisors[sched.level - 1];
+    if (projected > SCHED_HEADROOM * sched.tick_ms) {
+        sched.clean_windows = 0;
+        return;
+    }
+    if (++sched.clean_windows >= SCHED_RESTORE_WINDOWS) {
+        sched.level--;
+        sched.clean_windows = 0;
+    }
+}
+
+/**
+ * Account for the tick that just finished
+ * @update_ms : Time spent on input and simulation
+ * @render_ms : Time spent rendering, zero for a skipped render
+ */
+void sched_end_tick(double update_ms, double render_ms)
+{
+    sched.ticks++;
+    sched.update_ms += update_ms;
+    if (render_ms > 0.0) {
+        sched.renders++;
+        sched.render_ms += render_ms;
+    }
+    if (sched.late || update_ms + render_ms > sched.tick_ms)
+        sched.misses++;
+
+    double now = state_get_time_ms();
+    if (now - sched.window_start < SCHED_WINDOW_MS)
+        return;
+
+    sched.stats.deadline_misses += sched.misses;
+    sched_decide();
+
+    sched.window_start = now;
+    sched.ticks = sched.misses = sched.renders = 0;
+    sched.update_ms = sched.render_ms = 0.0;
+}
+
+/**
+ * Current scheduling mode and counters
+ * @stats : Filled in; without a scheduler every tick renders
+ */
+void sched_get_stats(sched_stats_t *stats)
+{
+    const game_config_t *cfg = ensure_cfg();
+
+    *stats = sched.stats;
+    stats->render_fps =
+        sched.enabled ? level_fps(sched.level) : cfg->timing.target_fps;
+}
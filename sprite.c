@@ -44,6 +44,12 @@ static const uint8_t trex_duck_rle[] = {
 static int cactus_data[104], rock_data[33], egg_data[78], pterodactyl_data[384],
     trex_normal_data[330], trex_duck_data[450];
 
+/* Run lists at every scale */
+static sprite_runs_t cactus_runs[SPRITE_SCALE_MAX],
+    rock_runs[SPRITE_SCALE_MAX], egg_runs[SPRITE_SCALE_MAX],
+    pterodactyl_runs[SPRITE_SCALE_MAX], trex_normal_runs[SPRITE_SCALE_MAX],
+    trex_duck_runs[SPRITE_SCALE_MAX];
+
 static void decompress_rle_to_buffer(const uint8_t *rle,
                                      size_t rle_size,
                                      int *buf)
@@ -55,6 +61,38 @@ static void decompress_rle_to_buffer(const uint8_t *rle,
     }
 }
 
+/*
+ * Split every pixel row of a sprite into runs of set pixels and store them
+ * scaled by each factor, so that drawing costs one block per run at any size.
+ */
+static void build_sprite_runs(const sprite_t *sprite)
+{
+    for (int scale = 1; scale <= SPRITE_SCALE_MAX; scale++) {
+        sprite_runs_t *list = &sprite->scaled[scale - 1];
+        list->count = 0;
+
+        for (int i = 0; i < sprite->rows; i++) {
+            for (int j = 0; j < sprite->cols; j++) {
+                if (!sprite_get_pixel(sprite, i, j) ||
+                    sprite_get_pixel(sprite, i, j - 1))
+                    continue;
+
+                int end = j + 1;
+                while (sprite_get_pixel(sprite, i, end))
+                    end++;
+                if (list->count == SPRITE_RUNS_MAX)
+                    break;
+                list->runs[list->count++] = (sprite_run_t) {
+                    .x = j * scale,
+                    .y = i * scale,
+                    .cols = (end - j) * scale,
+                    .rows = scale,
+                };
+            }
+        }
+    }
+}
+
 static void decompress_sprite_data(void)
 {
     static bool initialized = false;
@@ -71,6 +109,13 @@ static void decompress_sprite_data(void)
     decompress_rle_to_buffer(trex_duck_rle, sizeof(trex_duck_rle),
                              trex_duck_data);
 
+    build_sprite_runs(&sprite_cactus);
+    build_sprite_runs(&sprite_rock);
+    build_sprite_runs(&sprite_egg);
+    build_sprite_runs(&sprite_pterodactyl);
+    build_sprite_runs(&sprite_trex_normal);
+    build_sprite_runs(&sprite_trex_duck);
+
     initialized = true;
 }
 
@@ -83,31 +128,37 @@ void sprites_init(void)
 /* Sprite descriptors with lazy initialization */
 const sprite_t sprite_cactus = {
     .data = cactus_data,
+    .scaled = cactus_runs,
     .rows = 8,
     .cols = 13,
 };
 const sprite_t sprite_rock = {
     .data = rock_data,
+    .scaled = rock_runs,
     .rows = 3,
     .cols = 11,
 };
 const sprite_t sprite_egg = {
     .data = egg_data,
+    .scaled = egg_runs,
     .rows = 6,
     .cols = 13,
 };
 const sprite_t sprite_pterodactyl = {
     .data = pterodactyl_data,
+    .scaled = pterodactyl_runs,
     .rows = 12,
     .cols = 32,
 };
 const sprite_t sprite_trex_normal = {
     .data = trex_normal_data,
+    .scaled = trex_normal_runs,
     .rows = 15,
     .cols = 22,
 };
 const sprite_t sprite_trex_duck = {
     .data = trex_duck_data,
+    .scaled = trex_duck_runs,
     .rows = 15,
     .cols = 30,
 };
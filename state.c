@@ -5,8 +5,6 @@
 
 static screen_type_t current_screen = SCREEN_MENU, previous_screen;
 
-static double last_update_time = 0.0;
-
 double state_get_time_ms()
 {
     struct timespec now;
@@ -16,6 +14,16 @@ double state_get_time_ms()
     return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
 }
 
+/* Monotonic time for the simulation, read once per step */
+int64_t state_get_time_ns(void)
+{
+    struct timespec now;
+    if (clock_gettime(CLOCK_MONOTONIC, &now))
+        return 0;
+
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
 void state_initialize()
 {
     /* Create enhanced color pairs for the game */
@@ -32,26 +40,29 @@ void state_initialize()
     play_init_world();
 }
 
-void state_update_frame()
+/**
+ * Advance the active screen by one step of the game loop
+ * @step_ns : Simulated time, the same for every step
+ */
+void state_update_frame(int64_t step_ns)
 {
     /* Check the active screen, and call its update */
     switch (current_screen) {
     case SCREEN_MENU:
-        menu_update(TICKCOUNT - last_update_time);
+        menu_update((double) step_ns / NS_PER_MS);
         break;
     case SCREEN_WORLD:
-        play_update_world(TICKCOUNT - last_update_time);
+        play_update_world(step_ns);
         break;
     default:
         break;
     }
-
-    last_update_time = TICKCOUNT;
 }
 
 void state_render_frame()
 {
     /* Clear the back buffer instead of clearing the screen directly */
+    TRACE_BEGIN("compose");
     draw_clear_back_buffer();
 
     /* Check the active screen, and call its render */
@@ -63,9 +74,12 @@ void state_render_frame()
         play_render_world();
         break;
     }
+    TRACE_END("compose");
+    flight_mark(FLIGHT_COMPOSE);
 
     /* Swap buffers to display the rendered frame */
     draw_swap_buffers();
+    flight_mark(FLIGHT_REFRESH);
 }
 
 screen_type_t state_get_screen_type()
@@ -82,7 +96,6 @@ void state_set_screen_type(screen_type_t screen)
 {
     previous_screen = current_screen;
     current_screen = screen;
-    last_update_time = TICKCOUNT;
 
     if (screen == SCREEN_WORLD)
         play_init_world();
@@ -130,3 +143,8 @@ bool state_is_running()
 {
     return state_game_running;
 }
+
+bool state_is_quiescent(void)
+{
+    return current_screen == SCREEN_MENU || play_is_dead();
+}
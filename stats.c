@@ -0,0 +1,184 @@
+/*
+ * Live statistics for trex-top
+ *
+ * Publishes the counters of this session into a shared page, see stats.h.
+ * Frames only record their duration; every STATS_PERIOD_MS the rates, the
+ * frame time percentiles and the renderer counters are written out under the
+ * sequence lock. Nothing here allocates or makes a system call per frame.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "stats.h"
+#include "trex.h"
+
+#define STATS_PERIOD_MS 250.0
+#define STATS_WINDOW 128 /* Frames behind the frame time percentiles */
+
+static struct {
+    volatile stats_page_t *page;
+    char name[32];
+
+    /* Current frame */
+    double frame_start;
+
+    /* Ring of the latest frame times */
+    float frame_ms[STATS_WINDOW];
+    uint64_t recorded;
+
+    /* Since the last update */
+    uint64_t frames;
+    double last_update;
+    tui_stats_t last_out;
+} stats;
+
+/**
+ * Create the shared page of this session
+ * @mode : Shown by trex-top, "play" or "grid"
+ *
+ * Returns false if the page could not be created.
+ */
+bool stats_open(const char *mode)
+{
+    snprintf(stats.name, sizeof(stats.name), "/" STATS_SHM_PREFIX "%d",
+             (int) getpid());
+
+    int fd = shm_open(stats.name, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+                      0644);
+    if (fd == -1)
+        return false;
+
+    void *page = MAP_FAILED;
+    if (!ftruncate(fd, sizeof(stats_page_t)))
+        page = mmap(NULL, sizeof(stats_page_t), PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED) {
+        shm_unlink(stats.name);
+        return false;
+    }
+
+    stats.page = page;
+    stats.page->version = STATS_VERSION;
+    stats.page->pid = getpid();
+    snprintf((char *) stats.page->mode, sizeof(stats.page->mode), "%s",
+             mode);
+    stats.last_update = state_get_time_ms();
+    tui_get_stats(&stats.last_out);
+
+    /* Readers skip the page until it is complete */
+    __atomic_store_n(&stats.page->magic, STATS_MAGIC, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* Remove the page, also called from the fatal signal handler */
+void stats_close(void)
+{
+    if (!stats.page)
+        return;
+
+    munmap((void *) stats.page, sizeof(stats_page_t));
+    stats.page = NULL;
+    shm_unlink(stats.name);
+}
+
+void stats_begin_frame(void)
+{
+    if (stats.page)
+        stats.frame_start = state_get_time_ms();
+}
+
+/* 99th percentile and maximum of the last STATS_WINDOW frame times */
+static void frame_percentiles(float *p99, float *max)
+{
+    int n = stats.recorded < STATS_WINDOW ? (int) stats.recorded
+                                          : STATS_WINDOW;
+    int skip = n / 100; /* Frames above the 99th percentile */
+    float ms[STATS_WINDOW];
+
+    memcpy(ms, stats.frame_ms, n * sizeof(float));
+
+    /* Move the skip + 1 longest frames to the front, longest first */
+    for (int i = 0; i <= skip && i < n; i++) {
+        int longest = i;
+        for (int j = i + 1; j < n; j++)
+            if (ms[j] > ms[longest])
+                longest = j;
+        float t = ms[i];
+        ms[i] = ms[longest];
+        ms[longest] = t;
+    }
+
+    *p99 = n ? ms[skip] : 0.0f;
+    *max = n ? ms[0] : 0.0f;
+}
+
+static void stats_update(double now, int objects, int level, int score)
+{
+    volatile stats_page_t *p = stats.page;
+    double secs = (now - stats.last_update) / 1000.0;
+    tui_stats_t out;
+    tui_get_stats(&out);
+    sched_stats_t sched;
+    sched_get_stats(&sched);
+
+    float p99, max;
+    frame_percentiles(&p99, &max);
+
+    __atomic_store_n(&p->seq, p->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    p->updated_ns = state_get_time_ns();
+    p->rows = state_get_rows();
+    p->cols = state_get_cols();
+    p->objects = objects;
+    p->level = level;
+    p->score = score;
+    p->fps = stats.frames / secs;
+    p->bytes_per_sec = (out.bytes - stats.last_out.bytes) / secs;
+    p->writes_per_sec = (out.writes - stats.last_out.writes) / secs;
+    p->frame_p99_ms = p99;
+    p->frame_max_ms = max;
+    p->frames = stats.recorded;
+    p->bytes = out.bytes;
+    p->writes = out.writes;
+    p->vectors = out.vectors;
+    p->short_writes = out.short_writes;
+    p->fill_runs = out.fill_runs;
+    p->fill_cells = out.fill_cells;
+    p->esc_hits = out.esc_hits;
+    p->esc_misses = out.esc_misses;
+    p->render_fps = sched.render_fps;
+    p->deadline_misses = sched.deadline_misses;
+    p->dropped_ticks = sched.dropped_ticks;
+    p->throttled_windows = sched.throttled_windows;
+
+    __atomic_store_n(&p->seq, p->seq + 1, __ATOMIC_RELEASE);
+
+    stats.frames = 0;
+    stats.last_update = now;
+    stats.last_out = out;
+}
+
+/**
+ * Record the frame that just finished, publish if the period is over
+ * @objects : Live game objects
+ * @level : Current level, the highest one in grid mode
+ * @score : Current score, the highest one in grid mode
+ */
+void stats_end_frame(int objects, int level, int score)
+{
+    if (!stats.page)
+        return;
+
+    double now = state_get_time_ms();
+    stats.frame_ms[stats.recorded++ % STATS_WINDOW] = now - stats.frame_start;
+    stats.frames++;
+
+    if (now - stats.last_update >= STATS_PERIOD_MS)
+        stats_update(now, objects, level, score);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+/*
+ * Live session statistics in shared memory
+ *
+ * Used by "trex --stats" and the trex-top monitor. Each session maps one page
+ * under /dev/shm named STATS_SHM_PREFIX followed by its pid and rewrites it a
+ * few times per second. Readers map the pages read-only and copy them out, so
+ * watching a session costs it nothing.
+ *
+ * The page is guarded by a sequence lock: the writer makes seq odd, updates
+ * the fields and makes seq even again. A reader copies the page between two
+ * reads of seq and keeps the copy only when both are the same even number.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define STATS_MAGIC 0x54535453u /* "STST" */
+#define STATS_VERSION 2
+#define STATS_SHM_DIR "/dev/shm"
+#define STATS_SHM_PREFIX "trex-stats."
+
+/* Pages not rewritten for this long belong to idle or stuck sessions */
+#define STATS_STALE_MS 2000
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seq; /* Odd while the page is being written */
+    int32_t pid;
+    char mode[8]; /* "play" or "grid" */
+
+    /* CLOCK_MONOTONIC of the last update */
+    uint64_t updated_ns;
+
+    /* Screen and game */
+    uint16_t rows, cols;
+    uint32_t objects;
+    uint32_t level;
+    uint32_t score;
+
+    /* Over the last update period */
+    float fps;
+    float bytes_per_sec;
+    float writes_per_sec;
+
+    /* Over the last STATS_WINDOW frames */
+    float frame_p99_ms;
+    float frame_max_ms;
+
+    /* Since startup */
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t writes;
+    uint64_t vectors;      /* iovecs passed to writev() */
+    uint64_t short_writes; /* Partial and failed writes */
+    uint64_t fill_runs;    /* Runs sent as a single REP or ECH */
+    uint64_t fill_cells;   /* Cells covered by them */
+    uint64_t esc_hits;     /* Escape sequence cache */
+    uint64_t esc_misses;
+
+    /* Render rate scheduling, see sched.c */
+    uint32_t render_fps; /* 60, 30 or 20 while the CPU is short */
+    uint64_t deadline_misses;
+    uint64_t dropped_ticks;
+    uint64_t throttled_windows; /* Seconds the cgroup ran out of quota */
+} stats_page_t;
+
+/**
+ * Copy a page written by a live session
+ * @page : Shared page
+ * @copy : Consistent snapshot of the page
+ *
+ * Returns false if the page is not a trex stats page or kept changing under
+ * the reader.
+ */
+static inline bool stats_page_read(const volatile stats_page_t *page,
+                                   stats_page_t *copy)
+{
+    for (int tries = 0; tries < 100; tries++) {
+        uint32_t seq = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1)
+            continue;
+
+        memcpy(copy, (const void *) page, sizeof(*copy));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&page->seq, __ATOMIC_RELAXED) == seq)
+            return copy->magic == STATS_MAGIC &&
+                   copy->version == STATS_VERSION;
+    }
+    return false;
+}
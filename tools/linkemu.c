@@ -0,0 +1,675 @@
+/*
+ * Run trex behind an emulated network link
+ *
+ * The game runs on the slave side of a pseudo terminal. This process drains
+ * the master side no faster than the link bandwidth allows, so a game that
+ * writes more than the link carries fills the pty and blocks in write(), as
+ * it would behind a slow SSH session. Drained bytes are delivered after the
+ * link latency plus a random jitter, in order, and scripted keys travel the
+ * other way with the same latency.
+ *
+ * Frames are found in the stream by the end of their synchronized update
+ * (DEC mode 2026), which trex sends on xterm compatible terminals. At exit it
+ * reports how many frames arrived and how regularly, how long a key took to
+ * show up in a delivered frame, and how often the game was stuck writing.
+ *
+ *   tools/linkemu -p ssh -t 20 -- ./trex
+ *   tools/linkemu -b 256 -l 120 -j 40 -i keys.txt -- ./trex --grid 4
+ *
+ * An input script has one key per line, "MS KEYS", with C escapes in KEYS:
+ *
+ *   500 \r
+ *   1200 \x20
+ *   1250 \e[B
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NS_PER_MS 1000000LL
+#define NS_PER_SEC 1000000000LL
+
+#define SAMPLE_NS NS_PER_MS  /* Loop period, stall sampling resolution */
+#define CHUNKS_MAX 65536     /* Reads in flight on the link */
+#define KEYS_MAX 1024        /* Scripted keys */
+#define KEY_BYTES 16         /* Longest key sequence */
+#define BURST_MS 5           /* Token bucket depth in link time */
+
+static const char frame_end[] = "\x1b[?2026l";
+
+typedef struct {
+    const char *name;
+    int kbit, latency_ms, jitter_ms;
+} link_profile_t;
+
+static const link_profile_t profiles[] = {
+    {"lan", 0, 0, 0},
+    {"ssh", 1000, 30, 5},
+    {"mobile", 384, 120, 40},
+    {NULL, 0, 0, 0},
+};
+
+/* Bytes read from the pty, on their way to the far end */
+typedef struct {
+    int64_t due_ns;
+    uint64_t end; /* Stream offset after the last byte */
+} chunk_t;
+
+typedef struct {
+    int64_t at_ns; /* Pressed at the near end */
+    int64_t arrive_ns;
+    char bytes[KEY_BYTES];
+    int len;
+    uint64_t offset;    /* Output written before the key arrived */
+    uint64_t target;    /* End of the first frame drawn after it */
+    bool armed, sent, done;
+} script_key_t;
+
+/* Growable array of samples in milliseconds */
+typedef struct {
+    double *v;
+    size_t n, cap;
+} samples_t;
+
+static struct {
+    int kbit, latency_ms, jitter_ms;
+    int rows, cols;
+    double seconds;
+
+    int master;
+    pid_t pid;
+    int64_t start_ns;
+
+    /* Downlink */
+    double tokens;
+    chunk_t chunks[CHUNKS_MAX];
+    size_t chunk_head, chunk_count;
+    uint64_t read_bytes, delivered_bytes;
+    int64_t last_due_ns;
+    size_t match; /* Bytes of frame_end matched so far */
+
+    /* Frame ends by stream offset, read but not yet delivered */
+    uint64_t *frame_ends;
+    size_t frame_head, frame_count, frame_cap;
+    uint64_t frames_read, frames_delivered;
+    int64_t last_frame_ns;
+    samples_t intervals;
+
+    /* Uplink */
+    script_key_t keys[KEYS_MAX];
+    int nkeys;
+    samples_t key_latency;
+
+    /* Game stuck in write() */
+    int syscall_fd;
+    int64_t stall_since_ns;
+    int64_t stalled_ns, longest_stall_ns;
+    int stalls;
+} emu;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static void samples_add(samples_t *s, double v)
+{
+    if (s->n == s->cap) {
+        s->cap = s->cap ? 2 * s->cap : 256;
+        s->v = realloc(s->v, s->cap * sizeof(double));
+        if (!s->v) {
+            perror("linkemu");
+            exit(1);
+        }
+    }
+    s->v[s->n++] = v;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/* Percentile of sorted samples, p in [0, 100] */
+static double percentile(const samples_t *s, double p)
+{
+    if (!s->n)
+        return 0.0;
+    size_t i = (size_t) (p / 100.0 * (s->n - 1) + 0.5);
+    return s->v[i];
+}
+
+static int64_t jitter_ns(void)
+{
+    if (!emu.jitter_ms)
+        return 0;
+    return (int64_t) ((drand48() * 2.0 - 1.0) * emu.jitter_ms * NS_PER_MS);
+}
+
+/* Delivery time of something sent now, never before earlier traffic */
+static int64_t link_due(int64_t now, int64_t *last)
+{
+    int64_t due = now + emu.latency_ms * NS_PER_MS + jitter_ns();
+    if (due < *last)
+        due = *last;
+    *last = due;
+    return due;
+}
+
+/* Decode C escapes in place, returns the length */
+static int unescape(char *s)
+{
+    char *start = s, *out = s;
+
+    while (*s) {
+        if (*s != '\\' || !s[1]) {
+            *out++ = *s++;
+            continue;
+        }
+        s++;
+        switch (*s) {
+        case 'r':
+            *out++ = '\r';
+            break;
+        case 'n':
+            *out++ = '\n';
+            break;
+        case 't':
+            *out++ = '\t';
+            break;
+        case 'e':
+            *out++ = 0x1b;
+            break;
+        case 'x': {
+            char hex[3] = {0};
+            for (int i = 0; i < 2 && s[1] && strchr("0123456789abcdefABCDEF",
+                                                    s[1]);
+                 i++)
+                hex[i] = *++s;
+            *out++ = (char) strtol(hex, NULL, 16);
+            break;
+        }
+        default:
+            *out++ = *s;
+            break;
+        }
+        s++;
+    }
+
+    return (int) (out - start);
+}
+
+static void add_key(int64_t ms, const char *bytes, int len)
+{
+    if (emu.nkeys == KEYS_MAX || len <= 0 || len > KEY_BYTES) {
+        fprintf(stderr, "linkemu: skipping key at %lld ms\n", (long long) ms);
+        return;
+    }
+    script_key_t *k = &emu.keys[emu.nkeys++];
+    k->at_ns = ms * NS_PER_MS;
+    memcpy(k->bytes, bytes, len);
+    k->len = len;
+}
+
+static int load_script(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\n")] = '\0';
+
+        char *end;
+        long long ms = strtoll(line, &end, 10);
+        if (end == line || *line == '#')
+            continue;
+        while (*end == ' ' || *end == '\t')
+            end++;
+
+        char *keys = end;
+        int len = unescape(keys);
+        add_key(ms, keys, len);
+    }
+
+    fclose(f);
+    return 0;
+}
+
+/* Start the game, then jump every 750 ms */
+static void default_script(void)
+{
+    add_key(500, "\r", 1);
+    for (int64_t ms = 1250; ms < emu.seconds * 1000; ms += 750)
+        add_key(ms, " ", 1);
+}
+
+static pid_t spawn(char *const argv[])
+{
+    struct winsize ws = {.ws_row = emu.rows, .ws_col = emu.cols};
+    int slave;
+
+    if (openpty(&emu.master, &slave, NULL, NULL, &ws) == -1)
+        return -1;
+
+    pid_t pid = fork();
+    if (pid == -1)
+        return -1;
+
+    if (pid == 0) {
+        close(emu.master);
+        setsid();
+        ioctl(slave, TIOCSCTTY, 0);
+        dup2(slave, STDIN_FILENO);
+        dup2(slave, STDOUT_FILENO);
+        dup2(slave, STDERR_FILENO);
+        if (slave > STDERR_FILENO)
+            close(slave);
+        setenv("TERM", "xterm-256color", 1);
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+
+    close(slave);
+    fcntl(emu.master, F_SETFL, O_NONBLOCK);
+    return pid;
+}
+
+/* Record frame ends in bytes just read from the pty */
+static void scan_frames(const char *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] == frame_end[emu.match]) {
+            emu.match++;
+        } else {
+            emu.match = buf[i] == frame_end[0];
+            continue;
+        }
+        if (emu.match < sizeof(frame_end) - 1)
+            continue;
+        emu.match = 0;
+
+        uint64_t end = emu.read_bytes + i + 1;
+        if (emu.frame_count == emu.frame_cap) {
+            size_t cap = emu.frame_cap ? 2 * emu.frame_cap : 1024;
+            uint64_t *ends = malloc(cap * sizeof(uint64_t));
+            if (!ends) {
+                perror("linkemu");
+                exit(1);
+            }
+            for (size_t k = 0; k < emu.frame_count; k++)
+                ends[k] = emu.frame_ends[(emu.frame_head + k) %
+                                          emu.frame_cap];
+            free(emu.frame_ends);
+            emu.frame_ends = ends;
+            emu.frame_head = 0;
+            emu.frame_cap = cap;
+        }
+        emu.frame_ends[(emu.frame_head + emu.frame_count++) %
+                        emu.frame_cap] = end;
+        emu.frames_read++;
+
+        /* The first frame to start after a key arrived answers it */
+        for (int k = 0; k < emu.nkeys; k++) {
+            script_key_t *key = &emu.keys[k];
+            if (!key->sent || key->target)
+                continue;
+            if (key->armed)
+                key->target = end;
+            else if (end >= key->offset)
+                key->armed = true;
+        }
+    }
+}
+
+/* Drain the pty as far as the bandwidth allows */
+static void link_read(int64_t now, int64_t elapsed)
+{
+    static char buf[65536];
+    double rate = emu.kbit * 1000.0 / 8.0 / NS_PER_SEC; /* Bytes per ns */
+    size_t want = sizeof(buf);
+
+    if (emu.kbit) {
+        double burst = rate * BURST_MS * NS_PER_MS;
+        if (burst < 1500)
+            burst = 1500;
+        emu.tokens += rate * elapsed;
+        if (emu.tokens > burst)
+            emu.tokens = burst;
+        if (emu.tokens < 1.0)
+            return;
+        if (want > (size_t) emu.tokens)
+            want = (size_t) emu.tokens;
+    }
+    if (emu.chunk_count == CHUNKS_MAX)
+        return;
+
+    ssize_t n = read(emu.master, buf, want);
+    if (n <= 0)
+        return;
+
+    scan_frames(buf, n);
+    emu.read_bytes += n;
+    if (emu.kbit)
+        emu.tokens -= n;
+
+    chunk_t *c = &emu.chunks[(emu.chunk_head + emu.chunk_count++) %
+                              CHUNKS_MAX];
+    c->due_ns = link_due(now, &emu.last_due_ns);
+    c->end = emu.read_bytes;
+}
+
+/* Hand over the bytes whose latency has passed */
+static void link_deliver(int64_t now)
+{
+    while (emu.chunk_count &&
+           emu.chunks[emu.chunk_head].due_ns <= now) {
+        emu.delivered_bytes = emu.chunks[emu.chunk_head].end;
+        emu.chunk_head = (emu.chunk_head + 1) % CHUNKS_MAX;
+        emu.chunk_count--;
+    }
+
+    while (emu.frame_count &&
+           emu.frame_ends[emu.frame_head] <= emu.delivered_bytes) {
+        emu.frame_head = (emu.frame_head + 1) % emu.frame_cap;
+        emu.frame_count--;
+        emu.frames_delivered++;
+        if (emu.last_frame_ns)
+            samples_add(&emu.intervals,
+                        (double) (now - emu.last_frame_ns) / NS_PER_MS);
+        emu.last_frame_ns = now;
+    }
+
+    for (int k = 0; k < emu.nkeys; k++) {
+        script_key_t *key = &emu.keys[k];
+        if (key->target && !key->done &&
+            key->target <= emu.delivered_bytes) {
+            key->done = true;
+            samples_add(&emu.key_latency,
+                        (double) (now - emu.start_ns - key->at_ns) /
+                            NS_PER_MS);
+        }
+    }
+}
+
+/* Send the scripted keys that reached the far end of the uplink */
+static void link_input(int64_t now)
+{
+    static int64_t last_due;
+
+    for (int k = 0; k < emu.nkeys; k++) {
+        script_key_t *key = &emu.keys[k];
+        if (key->sent || now - emu.start_ns < key->at_ns)
+            continue;
+        if (!key->arrive_ns)
+            key->arrive_ns = link_due(emu.start_ns + key->at_ns, &last_due);
+        if (now < key->arrive_ns)
+            continue;
+
+        int pending = 0;
+        ioctl(emu.master, FIONREAD, &pending);
+        if (write(emu.master, key->bytes, key->len) != key->len)
+            continue;
+        key->offset = emu.read_bytes + pending;
+        key->sent = true;
+    }
+}
+
+/* Sample whether the game is blocked writing to the terminal */
+static void sample_stall(int64_t now)
+{
+    char buf[128];
+
+    if (emu.syscall_fd < 0)
+        return;
+
+    ssize_t n = pread(emu.syscall_fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0)
+        return;
+    buf[n] = '\0';
+
+    char *end;
+    long nr = strtol(buf, &end, 10);
+    long fd = end != buf ? strtol(end, NULL, 16) : -1;
+    bool stalled = end != buf && (nr == SYS_write || nr == SYS_writev) &&
+                   (fd == STDOUT_FILENO || fd == STDERR_FILENO);
+
+    if (stalled && !emu.stall_since_ns) {
+        emu.stall_since_ns = now;
+    } else if (!stalled && emu.stall_since_ns) {
+        int64_t d = now - emu.stall_since_ns;
+        emu.stalled_ns += d;
+        if (d > emu.longest_stall_ns)
+            emu.longest_stall_ns = d;
+        emu.stalls++;
+        emu.stall_since_ns = 0;
+    }
+}
+
+static void report(int64_t elapsed)
+{
+    double secs = (double) elapsed / NS_PER_SEC;
+
+    if (emu.kbit)
+        printf("link: %d kbit/s, %d ms latency, %d ms jitter, %dx%d, "
+               "%.1f s\n",
+               emu.kbit, emu.latency_ms, emu.jitter_ms, emu.rows,
+               emu.cols, secs);
+    else
+        printf("link: unlimited, %d ms latency, %d ms jitter, %dx%d, "
+               "%.1f s\n",
+               emu.latency_ms, emu.jitter_ms, emu.rows, emu.cols, secs);
+
+    printf("output: %llu bytes read, %llu delivered, %.0f bytes/s",
+           (unsigned long long) emu.read_bytes,
+           (unsigned long long) emu.delivered_bytes,
+           emu.read_bytes / secs);
+    if (emu.kbit)
+        printf(" (%.0f%% of the link)",
+               100.0 * emu.read_bytes * 8 / (emu.kbit * 1000.0 * secs));
+    printf("\n");
+
+    if (!emu.frames_read) {
+        printf("frames: none found, no synchronized updates in the "
+               "stream\n");
+    } else {
+        qsort(emu.intervals.v, emu.intervals.n, sizeof(double), cmp_double);
+        printf("frames: %llu read, %llu delivered (%.1f per second), "
+               "interval p50 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+               (unsigned long long) emu.frames_read,
+               (unsigned long long) emu.frames_delivered,
+               emu.frames_delivered / secs, percentile(&emu.intervals, 50),
+               percentile(&emu.intervals, 99),
+               percentile(&emu.intervals, 100));
+    }
+
+    int sent = 0;
+    for (int k = 0; k < emu.nkeys; k++)
+        sent += emu.keys[k].sent;
+    qsort(emu.key_latency.v, emu.key_latency.n, sizeof(double), cmp_double);
+    printf("input: %d keys sent, %zu answered, latency p50 %.1f ms, "
+           "p99 %.1f ms, max %.1f ms\n",
+           sent, emu.key_latency.n, percentile(&emu.key_latency, 50),
+           percentile(&emu.key_latency, 99),
+           percentile(&emu.key_latency, 100));
+
+    if (emu.syscall_fd < 0)
+        printf("writes: unknown, /proc/%d/syscall is not readable\n",
+               (int) emu.pid);
+    else
+        printf("writes: stalled %d times for %.1f ms (%.1f%% of the run), "
+               "longest %.1f ms\n",
+               emu.stalls, (double) emu.stalled_ns / NS_PER_MS,
+               100.0 * emu.stalled_ns / elapsed,
+               (double) emu.longest_stall_ns / NS_PER_MS);
+}
+
+/* Ask the game to quit, keep draining so it is not stuck in write() */
+static int stop_game(void)
+{
+    static char buf[65536];
+    int status = 0;
+
+    kill(emu.pid, SIGTERM);
+    for (int i = 0; i < 2000; i++) {
+        if (waitpid(emu.pid, &status, WNOHANG) == emu.pid)
+            return status;
+        while (read(emu.master, buf, sizeof(buf)) > 0)
+            ;
+        usleep(1000);
+    }
+
+    kill(emu.pid, SIGKILL);
+    waitpid(emu.pid, &status, 0);
+    return status;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] -- COMMAND [ARGS...]\n"
+            "Options:\n"
+            "  -p PROFILE  Link preset: lan, ssh (1 Mbit/s, 30 ms), mobile "
+            "(384 kbit/s, 120 ms)\n"
+            "  -b KBIT     Bandwidth in kbit/s, 0 for unlimited\n"
+            "  -l MS       One-way latency\n"
+            "  -j MS       Latency jitter, uniform in +/- MS\n"
+            "  -s RxC      Terminal size (default: 24x80)\n"
+            "  -t SECONDS  Run time (default: 10)\n"
+            "  -i FILE     Input script, \"MS KEYS\" per line (default: start "
+            "and jump)\n",
+            prog);
+}
+
+int main(int argc, char *argv[])
+{
+    const link_profile_t *profile = &profiles[1];
+    const char *script = NULL;
+    int kbit = -1, latency = -1, jitter = -1, opt;
+
+    emu.rows = 24;
+    emu.cols = 80;
+    emu.seconds = 10.0;
+
+    while ((opt = getopt(argc, argv, "p:b:l:j:s:t:i:h")) != -1) {
+        switch (opt) {
+        case 'p':
+            for (profile = profiles; profile->name; profile++)
+                if (!strcmp(profile->name, optarg))
+                    break;
+            if (!profile->name) {
+                fprintf(stderr, "linkemu: unknown profile %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'b':
+            kbit = atoi(optarg);
+            break;
+        case 'l':
+            latency = atoi(optarg);
+            break;
+        case 'j':
+            jitter = atoi(optarg);
+            break;
+        case 's':
+            if (sscanf(optarg, "%dx%d", &emu.rows, &emu.cols) != 2 ||
+                emu.rows < 1 || emu.cols < 1) {
+                fprintf(stderr, "linkemu: bad size %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 't':
+            emu.seconds = atof(optarg);
+            break;
+        case 'i':
+            script = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    emu.kbit = kbit >= 0 ? kbit : profile->kbit;
+    emu.latency_ms = latency >= 0 ? latency : profile->latency_ms;
+    emu.jitter_ms = jitter >= 0 ? jitter : profile->jitter_ms;
+    if (emu.jitter_ms > emu.latency_ms)
+        emu.jitter_ms = emu.latency_ms;
+
+    if (script) {
+        if (load_script(script))
+            return 1;
+    } else {
+        default_script();
+    }
+
+    srand48(1);
+    emu.pid = spawn(&argv[optind]);
+    if (emu.pid == -1) {
+        perror("linkemu: openpty");
+        return 1;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/syscall", (int) emu.pid);
+    emu.syscall_fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    emu.start_ns = now_ns();
+    int64_t last = emu.start_ns, end = emu.start_ns +
+                                        (int64_t) (emu.seconds * NS_PER_SEC);
+    bool exited = false;
+    int status = 0;
+
+    for (int64_t now = last; now < end; now = now_ns()) {
+        struct pollfd pfd = {.fd = emu.master, .events = POLLIN};
+        poll(&pfd, 1, 1);
+
+        now = now_ns();
+        link_read(now, now - last);
+        link_deliver(now);
+        link_input(now);
+        sample_stall(now);
+        last = now;
+
+        if (waitpid(emu.pid, &status, WNOHANG) == emu.pid) {
+            exited = true;
+            break;
+        }
+    }
+
+    int64_t elapsed = now_ns() - emu.start_ns;
+    if (emu.stall_since_ns)
+        sample_stall(emu.stall_since_ns + SAMPLE_NS);
+    report(elapsed);
+
+    if (!exited)
+        status = stop_game();
+    else
+        fprintf(stderr, "linkemu: %s exited early\n", argv[optind]);
+
+    return exited && !(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
@@ -0,0 +1,79 @@
+#!/usr/bin/env bash
+
+# Profile-guided build of trex, invoked by "make pgo"
+#
+# 1. Build a reference binary with the regular flags.
+# 2. Build an instrumented binary and train it on headless benchmark scenes:
+#    autoplayed games (the same game for a given seed) on screens of several
+#    sizes, with the default and the lean renderer.
+# 3. Rebuild with the recorded profile and link-time optimization.
+# 4. Bench the reference and the optimized binary on the same scenes with
+#    other seeds, and report the speedup.
+#
+# Everything is built below $PGO_DIR, the result is copied to ./trex.
+# CC, CFLAGS, LDFLAGS and SRCS come from the Makefile.
+
+set -e -u -o pipefail
+
+PGO_DIR=${PGO_DIR:-.pgo}
+TRAIN_FRAMES=${TRAIN_FRAMES:-2000}
+BENCH_FRAMES=${BENCH_FRAMES:-3000}
+
+# Screen size and seed of every training run, see "trex --scene"
+TRAIN_SCENES="24x80:3 50x160:1 50x160:11 100x300:5"
+# Held out: no benchmark scene may appear in TRAIN_SCENES
+BENCH_SCENES="24x80:21 50x160:7 100x300:23"
+
+OBJ="${PGO_DIR}/obj"
+PROFILE="$(pwd)/${PGO_DIR}/profile"
+
+# build OUTPUT EXTRA_FLAGS...: compile every source into $OBJ and link
+build() {
+    local out=$1
+    shift
+
+    # Profiles are matched by object path, so all builds use the same one
+    rm -rf "${OBJ}"
+    mkdir -p "${OBJ}"
+    for src in ${SRCS}; do
+        echo "  CC      ${OBJ}/${src%.c}.o"
+        ${CC} ${CFLAGS} "$@" -c -o "${OBJ}/${src%.c}.o" "${src}"
+    done
+    echo "  LD      ${out}"
+    ${CC} ${CFLAGS} "$@" -o "${out}" "${OBJ}"/*.o ${LDFLAGS}
+}
+
+# fps BINARY SCENE [OPTIONS...]: frames per second of one benchmark run
+fps() {
+    local bin=$1 scene=$2
+    shift 2
+    "${bin}" --bench "${BENCH_FRAMES}" --scene "${scene}" "$@" |
+        sed -n 's/^bench: .*(\([0-9]*\) frames\/s)$/\1/p'
+}
+
+mkdir -p "${PGO_DIR}"
+
+build "${PGO_DIR}/trex-ref"
+
+rm -rf "${PROFILE}"
+build "${PGO_DIR}/trex-gen" -fprofile-generate -fprofile-dir="${PROFILE}"
+for scene in ${TRAIN_SCENES}; do
+    echo "  TRAIN   ${scene}"
+    "${PGO_DIR}/trex-gen" --bench "${TRAIN_FRAMES}" --scene "${scene}" \
+        >/dev/null
+    "${PGO_DIR}/trex-gen" --bench "${TRAIN_FRAMES}" --scene "${scene}" \
+        --lean >/dev/null
+done
+
+build "${PGO_DIR}/trex-pgo" -fprofile-use -fprofile-dir="${PROFILE}" \
+    -fprofile-partial-training -Wno-missing-profile -flto=auto
+cp "${PGO_DIR}/trex-pgo" trex
+
+# Speedup per scene and their geometric mean
+for scene in ${BENCH_SCENES}; do
+    echo "${scene} $(fps "${PGO_DIR}/trex-ref" "${scene}")" \
+        "$(fps "${PGO_DIR}/trex-pgo" "${scene}")"
+done | awk '
+    BEGIN { printf "%-10s %10s %10s %8s\n", "scene", "ref fps", "pgo fps", "speedup" }
+    { printf "%-10s %10d %10d %7.2fx\n", $1, $2, $3, $3 / $2; log_sum += log($3 / $2) }
+    END { printf "%-10s %10s %10s %7.2fx\n", "geomean", "", "", exp(log_sum / NR) }'
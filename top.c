@@ -0,0 +1,464 @@
+/*
+ * trex-top: live table of the trex sessions on this host
+ *
+ * Every session started with "trex --stats" keeps a page of counters in
+ * shared memory, see stats.h. This maps the pages read-only and copies them
+ * out under their sequence lock, so the sessions being watched never notice:
+ * no signals, no sockets, no ptrace.
+ *
+ * Usage: trex-top [-d SECONDS] [-s COLUMN] [-b]
+ *   -d  Refresh interval (default: 1)
+ *   -s  Sort by a column, e.g. p99 or kb/s (default: fps)
+ *   -b  Print the table once and exit
+ *
+ * Keys: left/right or </> pick the sort column, r reverses, q quits.
+ */
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stats.h"
+#include "trex.h"
+
+#define TOP_SESSIONS_MAX 1024
+
+typedef struct {
+    int pid;
+    const volatile stats_page_t *page;
+    stats_page_t snap; /* Last consistent copy */
+    bool valid;
+    bool seen; /* Still listed in STATS_SHM_DIR */
+} session_t;
+
+typedef enum {
+    COL_PID,
+    COL_MODE,
+    COL_SIZE,
+    COL_FPS,
+    COL_RFPS,
+    COL_MISS,
+    COL_P99,
+    COL_MAX,
+    COL_KBPS,
+    COL_WPS,
+    COL_VEC,
+    COL_SHORT,
+    COL_FILL,
+    COL_ESC,
+    COL_OBJ,
+    COL_LEVEL,
+    COL_SCORE,
+    COL_AGE,
+    COLUMNS
+} column_id_t;
+
+static const struct {
+    const char *title;
+    int width;
+    int precision;
+} columns[COLUMNS] = {
+    [COL_PID] = {"pid", 7, 0},      [COL_MODE] = {"mode", 5, 0},
+    [COL_SIZE] = {"size", 8, 0},    [COL_FPS] = {"fps", 6, 1},
+    [COL_RFPS] = {"rfps", 5, 0},    [COL_MISS] = {"miss", 6, 0},
+    [COL_P99] = {"p99", 7, 2},      [COL_MAX] = {"max", 7, 2},
+    [COL_KBPS] = {"kb/s", 8, 1},    [COL_WPS] = {"wr/s", 6, 0},
+    [COL_VEC] = {"vec/wr", 7, 1},  [COL_SHORT] = {"short", 6, 0},
+    [COL_FILL] = {"fill/f", 7, 0},  [COL_ESC] = {"esc%", 6, 1},
+    [COL_OBJ] = {"obj", 5, 0},      [COL_LEVEL] = {"lvl", 4, 0},
+    [COL_SCORE] = {"score", 7, 0},  [COL_AGE] = {"age", 6, 1},
+};
+
+static struct {
+    session_t sessions[TOP_SESSIONS_MAX];
+    int count;
+    session_t *order[TOP_SESSIONS_MAX];
+
+    column_id_t sort;
+    bool reverse;
+    int64_t now_ns;
+} top = {.sort = COL_FPS};
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static bool is_stale(const session_t *s)
+{
+    return top.now_ns - (int64_t) s->snap.updated_ns >
+           STATS_STALE_MS * NS_PER_MS;
+}
+
+static const volatile stats_page_t *map_page(const char *name)
+{
+    char path[NAME_MAX + 2];
+    snprintf(path, sizeof(path), "/%s", name);
+
+    int fd = shm_open(path, O_RDONLY | O_CLOEXEC, 0);
+    if (fd == -1)
+        return NULL;
+
+    void *page =
+        mmap(NULL, sizeof(stats_page_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return page == MAP_FAILED ? NULL : page;
+}
+
+/* Pick up new sessions and drop the ones that ended */
+static void scan_sessions(void)
+{
+    DIR *dir = opendir(STATS_SHM_DIR);
+    if (!dir)
+        return;
+
+    for (int i = 0; i < top.count; i++)
+        top.sessions[i].seen = false;
+
+    const size_t prefix = strlen(STATS_SHM_PREFIX);
+    struct dirent *ent;
+    while ((ent = readdir(dir))) {
+        if (strncmp(ent->d_name, STATS_SHM_PREFIX, prefix) ||
+            !isdigit((unsigned char) ent->d_name[prefix]))
+            continue;
+        int pid = atoi(ent->d_name + prefix);
+
+        /* Pages left behind by sessions that were killed */
+        if (kill(pid, 0) == -1 && errno == ESRCH) {
+            char path[NAME_MAX + 2];
+            snprintf(path, sizeof(path), "/%s", ent->d_name);
+            shm_unlink(path);
+            continue;
+        }
+
+        session_t *s = NULL;
+        for (int i = 0; i < top.count && !s; i++)
+            if (top.sessions[i].pid == pid)
+                s = &top.sessions[i];
+        if (!s) {
+            if (top.count == TOP_SESSIONS_MAX)
+                continue;
+            const volatile stats_page_t *page = map_page(ent->d_name);
+            if (!page)
+                continue;
+            s = &top.sessions[top.count++];
+            *s = (session_t) {.pid = pid, .page = page};
+        }
+        s->seen = true;
+    }
+    closedir(dir);
+
+    for (int i = 0; i < top.count;) {
+        session_t *s = &top.sessions[i];
+        if (s->seen) {
+            i++;
+            continue;
+        }
+        munmap((void *) s->page, sizeof(stats_page_t));
+        *s = top.sessions[--top.count];
+    }
+}
+
+static void read_sessions(void)
+{
+    top.now_ns = now_ns();
+    for (int i = 0; i < top.count; i++) {
+        session_t *s = &top.sessions[i];
+        stats_page_t snap;
+        if (stats_page_read(s->page, &snap)) {
+            s->snap = snap;
+            s->valid = true;
+        }
+    }
+}
+
+static double column_value(const session_t *s, column_id_t col)
+{
+    const stats_page_t *p = &s->snap;
+    bool live = !is_stale(s);
+
+    switch (col) {
+    case COL_PID:
+        return s->pid;
+    case COL_MODE:
+        return p->mode[0];
+    case COL_SIZE:
+        return (double) p->rows * p->cols;
+    case COL_FPS:
+        return live ? p->fps : 0.0;
+    case COL_RFPS:
+        return p->render_fps;
+    case COL_MISS:
+        return p->deadline_misses;
+    case COL_P99:
+        return p->frame_p99_ms;
+    case COL_MAX:
+        return p->frame_max_ms;
+    case COL_KBPS:
+        return live ? p->bytes_per_sec / 1024.0 : 0.0;
+    case COL_WPS:
+        return live ? p->writes_per_sec : 0.0;
+    case COL_VEC:
+        return p->writes ? (double) p->vectors / p->writes : 0.0;
+    case COL_SHORT:
+        return p->short_writes;
+    case COL_FILL:
+        return p->frames ? (double) p->fill_cells / p->frames : 0.0;
+    case COL_ESC: {
+        uint64_t total = p->esc_hits + p->esc_misses;
+        return total ? 100.0 * p->esc_hits / total : 0.0;
+    }
+    case COL_OBJ:
+        return p->objects;
+    case COL_LEVEL:
+        return p->level;
+    case COL_SCORE:
+        return p->score;
+    case COL_AGE:
+        return (top.now_ns - (int64_t) p->updated_ns) / 1e9;
+    default:
+        return 0.0;
+    }
+}
+
+static int compare_sessions(const void *a, const void *b)
+{
+    const session_t *x = *(session_t *const *) a;
+    const session_t *y = *(session_t *const *) b;
+    double vx = column_value(x, top.sort), vy = column_value(y, top.sort);
+
+    /* Numbers sort largest first, the pid and mode smallest first */
+    int order = (vx < vy) - (vx > vy);
+    if (top.sort == COL_PID || top.sort == COL_MODE)
+        order = -order;
+    if (!order)
+        order = x->pid - y->pid;
+    return top.reverse ? -order : order;
+}
+
+static int sort_sessions(void)
+{
+    int n = 0;
+    for (int i = 0; i < top.count; i++)
+        if (top.sessions[i].valid)
+            top.order[n++] = &top.sessions[i];
+    qsort(top.order, n, sizeof(top.order[0]), compare_sessions);
+    return n;
+}
+
+static int format_header(char *line, size_t size)
+{
+    int len = 0;
+    for (int c = 0; c < COLUMNS && len < (int) size; c++)
+        len += snprintf(line + len, size - len, "%*s", columns[c].width,
+                        columns[c].title);
+    return len;
+}
+
+static void format_row(char *line, size_t size, const session_t *s)
+{
+    int len = 0;
+
+    for (int c = 0; c < COLUMNS && len < (int) size; c++) {
+        int w = columns[c].width;
+        if (c == COL_MODE) {
+            len += snprintf(line + len, size - len, "%*.*s", w, w - 1,
+                            is_stale(s) ? "idle" : s->snap.mode);
+        } else if (c == COL_SIZE) {
+            char size_str[16];
+            snprintf(size_str, sizeof(size_str), "%ux%u", s->snap.rows,
+                     s->snap.cols);
+            len += snprintf(line + len, size - len, "%*s", w, size_str);
+        } else {
+            len += snprintf(line + len, size - len, "%*.*f", w,
+                            columns[c].precision, column_value(s, c));
+        }
+    }
+}
+
+/* Column whose title is @name, or -1 */
+static int find_column(const char *name)
+{
+    for (int c = 0; c < COLUMNS; c++)
+        if (!strcasecmp(columns[c].title, name))
+            return c;
+    return -1;
+}
+
+static void print_once(void)
+{
+    char line[256];
+
+    scan_sessions();
+    read_sessions();
+    int n = sort_sessions();
+
+    format_header(line, sizeof(line));
+    puts(line);
+    for (int i = 0; i < n; i++) {
+        format_row(line, sizeof(line), top.order[i]);
+        puts(line);
+    }
+}
+
+static void draw_table(void)
+{
+    char line[256];
+    int rows = tui_get_max_y(tui_stdscr), cols = tui_get_max_x(tui_stdscr);
+
+    scan_sessions();
+    read_sessions();
+    int n = sort_sessions();
+
+    tui_clear_window(tui_stdscr);
+    tui_print_at(tui_stdscr, 0, 0, "trex-top: %d sessions, sorted by %s%s",
+                 n, columns[top.sort].title, top.reverse ? " (reversed)" : "");
+
+    /* Header, with the sort column highlighted */
+    int x = 0;
+    for (int c = 0; c < COLUMNS && x < cols; c++) {
+        if (c == (int) top.sort)
+            tui_wattron(tui_stdscr, TUI_A_REVERSE);
+        tui_print_at(tui_stdscr, 2, x, "%*s", columns[c].width,
+                     columns[c].title);
+        if (c == (int) top.sort)
+            tui_wattroff(tui_stdscr, TUI_A_REVERSE);
+        x += columns[c].width;
+    }
+
+    for (int i = 0; i < n && 3 + i < rows; i++) {
+        format_row(line, sizeof(line), top.order[i]);
+        if (cols < (int) sizeof(line))
+            line[cols] = '\0';
+        tui_print_at(tui_stdscr, 3 + i, 0, "%s", line);
+    }
+
+    tui_refresh(tui_stdscr);
+}
+
+/* Returns false when asked to quit */
+static bool handle_key(int ch)
+{
+    switch (ch) {
+    case 'q':
+    case 'Q':
+    case TUI_KEY_ESC:
+        return false;
+    case TUI_KEY_LEFT:
+    case '<':
+        top.sort = (top.sort + COLUMNS - 1) % COLUMNS;
+        break;
+    case TUI_KEY_RIGHT:
+    case '>':
+        top.sort = (top.sort + 1) % COLUMNS;
+        break;
+    case 'r':
+        top.reverse = !top.reverse;
+        break;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    double interval = 1.0;
+    bool batch = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:s:bh")) != -1) {
+        switch (opt) {
+        case 'd':
+            interval = atof(optarg);
+            if (interval <= 0.0) {
+                fprintf(stderr, "trex-top: bad interval %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 's': {
+            int col = find_column(optarg);
+            if (col < 0) {
+                fprintf(stderr, "trex-top: no column %s\n", optarg);
+                return 1;
+            }
+            top.sort = col;
+            break;
+        }
+        case 'b':
+            batch = true;
+            break;
+        default:
+            fprintf(stderr,
+                    "Usage: %s [-d SECONDS] [-s COLUMN] [-b]\n"
+                    "  -d  Refresh interval (default: 1)\n"
+                    "  -s  Sort column, e.g. p99 or kb/s (default: fps)\n"
+                    "  -b  Print the table once and exit\n",
+                    argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (batch) {
+        print_once();
+        return 0;
+    }
+
+    if (!tui_init()) {
+        fprintf(stderr, "trex-top: failed to initialize terminal\n");
+        return 1;
+    }
+    tui_raw();
+    tui_set_nodelay(tui_stdscr, true);
+    tui_set_keypad(tui_stdscr, true);
+    tui_noecho();
+    tui_set_cursor(0);
+    tui_cbreak();
+
+    bool running = true;
+    int64_t next = 0;
+    while (running) {
+        tui_check_shutdown();
+        tui_check_resize();
+
+        if (now_ns() >= next) {
+            draw_table();
+            next = now_ns() + (int64_t) (interval * 1e9);
+        }
+
+        struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+        int timeout = (int) ((next - now_ns()) / NS_PER_MS);
+        if (poll(&pfd, 1, timeout > 0 ? timeout : 0) <= 0)
+            continue;
+
+        bool redraw = false;
+        while (running && tui_has_input()) {
+            int ch = tui_getch();
+            if (ch == -1)
+                break;
+            running = handle_key(ch);
+            redraw = true;
+        }
+        if (running && redraw)
+            draw_table();
+    }
+
+    tui_noraw();
+    tui_set_cursor(1);
+    tui_echo();
+    tui_clear_screen();
+    tui_cleanup();
+
+    return 0;
+}
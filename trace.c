@@ -0,0 +1,194 @@
+/*
+ * Chrome trace-event timeline export
+ *
+ * With "--trace FILE", begin/end events of the frame phases are recorded and
+ * written at exit in the Chrome trace-event JSON format, which chrome://tracing
+ * and Perfetto load directly. Every thread records into its own ring, so the
+ * hot path takes no locks: the owner is the only writer and publishes the new
+ * head with a release store. Rings are linked into a global list with a CAS
+ * the first time a thread records an event. When a ring wraps, the oldest
+ * events are dropped.
+ *
+ * The same probes also maintain a per-thread stack of open phases, which the
+ * sampling profiler reads from its signal handler to tag samples.
+ *
+ * When neither is in use, TRACE_BEGIN()/TRACE_END() cost one test of
+ * trace_enabled.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trex.h"
+
+#define TRACE_RING_SIZE (1 << 16) /* Events per thread, power of two */
+#define TRACE_MAX_DEPTH 16         /* Tracked phase nesting */
+
+typedef struct {
+    uint64_t ts;      /* Nanoseconds since trace_open() */
+    const char *name; /* Static string */
+    char phase;       /* 'B' or 'E' */
+} trace_event_t;
+
+typedef struct trace_ring {
+    struct trace_ring *next;
+    long tid;
+    uint64_t head; /* Total events recorded, written by the owner only */
+    trace_event_t events[TRACE_RING_SIZE];
+} trace_ring_t;
+
+bool trace_enabled = false; /* Probes are active */
+
+static bool trace_recording; /* Events go to the rings */
+static const char *trace_path;
+static uint64_t trace_epoch;
+static trace_ring_t *trace_rings; /* Every thread that recorded an event */
+static __thread trace_ring_t *trace_ring;
+
+static __thread const char *trace_phases[TRACE_MAX_DEPTH];
+static __thread int trace_depth;
+
+static uint64_t trace_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+static trace_ring_t *trace_ring_register(void)
+{
+    trace_ring_t *ring = calloc(1, sizeof(trace_ring_t));
+    if (!ring)
+        return NULL;
+
+    ring->tid = syscall(SYS_gettid);
+
+    /* Lock-free push, the list is only walked at exit */
+    ring->next = __atomic_load_n(&trace_rings, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&trace_rings, &ring->next, ring, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+
+    return ring;
+}
+
+void trace_event(const char *name, char phase)
+{
+    if (phase == 'B') {
+        if (trace_depth < TRACE_MAX_DEPTH)
+            trace_phases[trace_depth] = name;
+        /* Publish the name before the depth to a signal handler */
+        __atomic_signal_fence(__ATOMIC_RELEASE);
+        trace_depth++;
+    } else if (trace_depth > 0) {
+        trace_depth--;
+    }
+
+    if (!trace_recording)
+        return;
+
+    trace_ring_t *ring = trace_ring;
+    if (!ring) {
+        ring = trace_ring = trace_ring_register();
+        if (!ring)
+            return;
+    }
+
+    uint64_t head = ring->head;
+    trace_event_t *ev = &ring->events[head & (TRACE_RING_SIZE - 1)];
+    ev->ts = trace_now_ns() - trace_epoch;
+    ev->name = name;
+    ev->phase = phase;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void trace_write_ring(FILE *out, const trace_ring_t *ring, bool *first)
+{
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t start = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+    int pid = getpid();
+    int depth = 0;
+
+    fprintf(out,
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,"
+            "\"tid\":%ld,\"args\":{\"name\":\"%s\"}}",
+            *first ? "" : ",\n", pid, ring->tid,
+            ring->tid == pid ? "main" : "worker");
+    *first = false;
+
+    for (uint64_t i = start; i < head; i++) {
+        const trace_event_t *ev = &ring->events[i & (TRACE_RING_SIZE - 1)];
+
+        /* Drop ends whose begin was overwritten when the ring wrapped */
+        if (ev->phase == 'E') {
+            if (depth == 0)
+                continue;
+            depth--;
+        } else {
+            depth++;
+        }
+
+        fprintf(out,
+                ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03llu,"
+                "\"pid\":%d,\"tid\":%ld}",
+                ev->name, ev->phase, (unsigned long long) (ev->ts / 1000),
+                (unsigned long long) (ev->ts % 1000), pid, ring->tid);
+    }
+}
+
+/* Write all rings to the trace file, also registered with atexit() */
+void trace_close(void)
+{
+    if (!trace_recording)
+        return;
+    trace_recording = false;
+
+    FILE *out = fopen(trace_path, "w");
+    if (!out) {
+        perror(trace_path);
+        return;
+    }
+
+    bool first = true;
+    fputs("{\"traceEvents\":[\n", out);
+    for (trace_ring_t *ring = __atomic_load_n(&trace_rings, __ATOMIC_ACQUIRE);
+         ring; ring = ring->next)
+        trace_write_ring(out, ring, &first);
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", out);
+    fclose(out);
+}
+
+/**
+ * Start recording frame phase events
+ * @path : File the Chrome trace JSON is written to at exit
+ */
+void trace_open(const char *path)
+{
+    trace_path = path;
+    trace_epoch = trace_now_ns();
+    trace_recording = true;
+    trace_enabled = true;
+    atexit(trace_close);
+}
+
+/* Keep track of the open phases without recording events */
+void trace_track_phases(void)
+{
+    trace_enabled = true;
+}
+
+/* Innermost open phase of the calling thread, safe in signal handlers */
+const char *trace_current_phase(void)
+{
+    int depth = trace_depth;
+    __atomic_signal_fence(__ATOMIC_ACQUIRE);
+
+    if (depth <= 0)
+        return NULL;
+    return trace_phases[depth <= TRACE_MAX_DEPTH ? depth - 1
+                                                 : TRACE_MAX_DEPTH - 1];
+}
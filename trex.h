@@ -8,6 +8,8 @@
  */
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #define LOGO_START_Y 9
 
@@ -76,11 +78,31 @@ extern tui_window_t *tui_curscr;
 #define TUI_ERR (-1)
 #define TUI_OK 0
 
+/* Output backends */
+typedef enum {
+    TUI_BACKEND_VT = 0,       /* VT escape sequences to the local terminal */
+    TUI_BACKEND_WIRE = 1,     /* Binary cell diffs over stdin/stdout */
+    TUI_BACKEND_HEADLESS = 2, /* VT escape sequences to /dev/null */
+} tui_backend_t;
+
 /* TUI initialization and cleanup */
+int tui_set_backend(tui_backend_t backend);
+void tui_set_headless_size(int rows, int cols);
+void tui_set_lean(bool lean);
 tui_window_t *tui_init(void);
 int tui_cleanup(void);
 bool tui_check_shutdown(void);
 bool tui_check_resize(void);
+void tui_set_resize_hook(void (*hook)(void));
+void tui_set_shutdown_hook(void (*hook)(void));
+
+/* Idle sessions, see tui_hibernate() */
+void tui_hibernate(void);
+void tui_wait_event(void);
+bool tui_wake(void);
+
+/* Apply a binary cell-diff message to the local screen (client side) */
+int tui_wire_apply(int type, const unsigned char *payload, size_t len);
 
 /* Terminal capability functions */
 tui_term_cap_t *tui_term_cap_new(void);
@@ -95,6 +117,11 @@ int tui_clear_window(tui_window_t *win);
 int tui_refresh(tui_window_t *win);
 int tui_endwin(void);
 
+/* Sub-windows */
+tui_window_t *tui_newwin(int nlines, int ncols, int begin_y, int begin_x);
+int tui_delwin(tui_window_t *win);
+int tui_wnoutrefresh(tui_window_t *win);
+
 /* Input configuration */
 int tui_raw(void);
 int tui_cbreak(void);
@@ -124,6 +151,7 @@ int tui_clear_screen(void);
 /* Text output */
 void tui_wprintw(tui_window_t *win, const char *fmt, ...);
 int tui_print_at(tui_window_t *win, int row, int col, const char *fmt, ...);
+void tui_fill(tui_window_t *win, int row, int col, int rows, int cols, char ch);
 
 /* Attribute management */
 int tui_wattron(tui_window_t *win, int attrs);
@@ -133,12 +161,142 @@ int tui_wattroff(tui_window_t *win, int attrs);
 int tui_get_max_x(tui_window_t *win);
 int tui_get_max_y(tui_window_t *win);
 
+/* Output counters since startup, sampled by the flight recorder and the soak
+ * test
+ */
+typedef struct {
+    uint64_t writes;       /* write()/writev() system calls */
+    uint64_t bytes;        /* Bytes written to the terminal */
+    uint64_t dirty_cells;  /* Cells inside the dirty region at refresh */
+    uint64_t esc_hits;     /* Escape sequence cache hits */
+    uint64_t esc_misses;   /* Escape sequence cache misses */
+    uint64_t pair_misses;  /* Color pair cache misses */
+    uint64_t vectors;      /* iovecs passed to writev() */
+    uint64_t short_writes; /* Partial writes and writev() fallbacks */
+    uint64_t fill_runs;    /* Runs sent as a single REP or ECH */
+    uint64_t fill_cells;   /* Cells covered by them */
+
+    /* Entries held by caches that never evict, current values */
+    uint32_t esc_interned; /* Interned sequences and attribute combos */
+    uint32_t pairs_used;   /* Color pair cache nodes */
+} tui_stats_t;
+
+void tui_get_stats(tui_stats_t *stats);
+
+/* Renderer memory of this session in bytes, see tui_get_footprint() */
+typedef struct {
+    size_t screen;  /* Cell, attribute and back buffers */
+    size_t cursor;  /* Cursor sequence cache */
+    size_t dirty;   /* Dirty tile grids and sparse tile pool */
+    size_t escapes; /* Escape sequence, attribute and LRU pools */
+    size_t output;  /* Terminal output buffer */
+    size_t fixed;   /* Tables that do not scale with the terminal */
+    size_t total;
+    /* Whole process from /proc, 0 when unknown. Private (anonymous) pages
+     * are what each extra session costs, file pages are mostly shared.
+     */
+    size_t rss_kb, anon_kb, peak_rss_kb;
+} tui_footprint_t;
+
+void tui_get_footprint(tui_footprint_t *fp);
+
 /* Debug statistics */
 void tui_debug_writev_stats(void);
 void tui_debug_rle_stats(void);
 void tui_debug_lru_cache(void);
 void tui_debug_string_interning(void);
 
+/* Frame phase tracing, see trace.c */
+extern bool trace_enabled;
+void trace_open(const char *path);
+void trace_close(void);
+void trace_track_phases(void);
+const char *trace_current_phase(void);
+void trace_event(const char *name, char phase);
+
+/* Only a single well-predicted branch when tracing is off */
+#define TRACE_BEGIN(name)                       \
+    do {                                        \
+        if (__builtin_expect(trace_enabled, 0)) \
+            trace_event(name, 'B');             \
+    } while (0)
+#define TRACE_END(name)                         \
+    do {                                        \
+        if (__builtin_expect(trace_enabled, 0)) \
+            trace_event(name, 'E');             \
+    } while (0)
+
+/* Heap allocation counting and steady-state enforcement, see alloc.c.
+ * Only built with ALLOC_GUARD=1, otherwise nothing is counted.
+ */
+#ifdef ALLOC_GUARD
+void alloc_guard_arm_after(int frames);
+void alloc_guard_frame(void);
+void alloc_guard_rewarm(void);
+void alloc_guard_disarm(void);
+uint64_t alloc_count(void);
+#else
+static inline void alloc_guard_frame(void) {}
+static inline void alloc_guard_rewarm(void) {}
+static inline void alloc_guard_disarm(void) {}
+static inline uint64_t alloc_count(void)
+{
+    return 0;
+}
+#endif
+
+/* Sampling profiler writing folded stacks, see profile.c */
+bool profile_open(const char *path);
+void profile_close(void);
+
+/* Live statistics in shared memory for trex-top, see stats.c */
+bool stats_open(const char *mode);
+void stats_close(void);
+void stats_begin_frame(void);
+void stats_end_frame(int objects, int level, int score);
+
+/* High-score table shared by all sessions on the host, see board.c */
+#define BOARD_SLOTS 16
+
+typedef struct {
+    int score;
+    int64_t when; /* Seconds since the epoch */
+    bool mine;    /* Set by this session */
+} board_entry_t;
+
+bool board_open(const char *path);
+void board_close(void);
+bool board_submit(int score);
+int board_read(board_entry_t *entries);
+
+/* Render rate scheduling under CPU contention, see sched.c */
+typedef struct {
+    int render_fps;             /* Frame rate the scheduler renders at */
+    uint64_t deadline_misses;   /* Ticks that started or ended late */
+    uint64_t dropped_ticks;     /* Backlog given up on */
+    uint64_t throttled_windows; /* Windows in which the cgroup was throttled */
+} sched_stats_t;
+
+void sched_open(double tick_ms);
+void sched_close(void);
+bool sched_begin_tick(double *backlog_ms);
+void sched_end_tick(double update_ms, double render_ms);
+void sched_get_stats(sched_stats_t *stats);
+
+/* Slow-frame flight recorder, see flight.c */
+typedef enum {
+    FLIGHT_INPUT,
+    FLIGHT_UPDATE,
+    FLIGHT_COMPOSE,
+    FLIGHT_REFRESH,
+    FLIGHT_PHASES
+} flight_phase_t;
+
+void flight_open(const char *path, double budget_ms);
+void flight_begin_frame(void);
+void flight_mark(flight_phase_t phase);
+void flight_end_frame(int objects);
+
 /* ========== Game Configuration (from config.h) ========== */
 
 /* Frame rate and timing configuration */
@@ -199,12 +357,17 @@ typedef struct {
     rgb_color_t score_text;
 } colors_config_t;
 
+/* Fixed-point unit of scroll speeds: SPEED_ONE is one cell per update */
+#define SPEED_ONE 256
+
 /* Level configuration */
 typedef struct {
     int level;
     int spawn_min;
     int spawn_max;
     int score_next;
+    /* Scroll speed ramps from start to end as the score nears score_next */
+    int speed_start, speed_end;
 } level_config_t;
 
 /* Object probability configuration */
@@ -360,15 +523,30 @@ int draw_get_color_id(color_t **colors,
                       short b2,
                       color_type_t type);
 
+/* Color lookups that missed the per-thread memo since startup */
+uint64_t draw_get_color_misses(void);
+
+/* Colors in the registry, which only shrinks on draw_cleanup_colors() */
+int draw_get_color_count(void);
+
 /* Render buffer management functions */
 void draw_init_buffers(void);
 void draw_cleanup_buffers(void);
 void draw_swap_buffers(void);
 void draw_clear_back_buffer(void);
 
+/* Redirect the calling thread's drawing into a window, NULL restores the
+ * back buffer
+ */
+void draw_set_target(tui_window_t *win);
+
 /* Color management cleanup */
 void draw_cleanup_colors(void);
 
+/* Release and restore the color registry while idle */
+void draw_hibernate(void);
+void draw_wake(void);
+
 /* Resolution is now dynamically obtained via state_get_resolution() */
 
 /* Forward declarations */
@@ -415,29 +593,71 @@ struct object {
     bounding_box_t bounding_box;
 };
 
+/* Game world, see play.c */
+typedef struct world world_t;
+
 /* Object management functions */
-void play_init_object(object_t *object);
-int play_find_free_slot();
-void play_add_object(int x, int y, object_type_t type);
-void play_cleanup_objects();
+void play_init_object(const world_t *w, object_t *object);
+int play_find_free_slot(world_t *w);
+void play_add_object(world_t *w, int x, int y, object_type_t type);
+void play_cleanup_objects(world_t *w);
 
 /* Rendering functions */
-void play_render_object(object_t const *object);
+void play_render_object(const world_t *w, object_t const *object);
+
+/* World instances */
+world_t *play_world_new(int rows, int cols, unsigned int seed);
+void play_world_free(world_t *w);
+void play_world_reset(world_t *w);
+void play_world_resize(world_t *w, int rows, int cols);
+void play_world_update(world_t *w, int64_t step_ns);
+void play_world_render(const world_t *w);
+void play_world_handle_input(world_t *w, int input);
+int play_world_bot_input(const world_t *w);
+int play_world_score(const world_t *w);
+int play_world_level(const world_t *w);
+bool play_world_is_dead(const world_t *w);
+int play_world_object_count(const world_t *w);
+int play_world_speed(const world_t *w);
+
+/* Spawn a world has planned, see play_world_upcoming() */
+typedef struct {
+    object_type_t type;
+    double eta; /* Milliseconds until it spawns */
+} spawn_plan_t;
+
+int play_world_upcoming(const world_t *w, spawn_plan_t *plan, int max);
 
-/* World management */
+/* Interactive world management */
 void play_init_world();
-void play_update_world(double elapsed);
+void play_update_world(int64_t step_ns);
 void play_render_world();
 void play_adjust_for_resize();
 
 /* Input handling */
 void play_handle_input(int input);
+int play_object_count(void);
+bool play_is_dead(void);
+int play_score(void);
+int play_level(void);
+
+/* Release and restore caches of the interactive world while idle */
+void play_hibernate(void);
+void play_wake(void);
 
 /* Object generation */
-object_type_t play_random_object(bool b_generate_egg);
+object_type_t play_random_object(world_t *w, bool b_generate_egg);
 
 /* Kill the player */
-void play_kill_player();
+void play_kill_player(world_t *w);
+
+/* Split-screen view running count autoplayed worlds, see grid.c */
+int grid_run(int count);
+
+/* Headless benchmark of an autoplayed world, see bench.c */
+void bench_set_scene(int rows, int cols, unsigned int seed);
+int bench_run(int frames);
+int bench_soak(int minutes);
 
 /* Game screen types */
 typedef enum {
@@ -446,11 +666,13 @@ typedef enum {
 } screen_type_t;
 
 /* Time management */
+#define NS_PER_MS 1000000LL
 double state_get_time_ms();
+int64_t state_get_time_ns(void);
 
 /* State initialization and main loop functions */
 void state_initialize();
-void state_update_frame();
+void state_update_frame(int64_t step_ns);
 void state_render_frame();
 
 /* Screen management */
@@ -469,10 +691,12 @@ void state_handle_input(int key_code);
 void state_quit_game();
 bool state_is_running();
 
+/* Nothing moves on screen until the next key */
+bool state_is_quiescent(void);
+
 /* Initialize sprite data */
 void sprites_init(void);
 
 /* Convenience macros */
 #define RESOLUTION_ROWS (state_get_rows())
 #define RESOLUTION_COLS (state_get_cols())
-#define TICKCOUNT (state_get_time_ms())
@@ -1,6 +1,10 @@
+#define _GNU_SOURCE
+
 #include <errno.h>
+#include <fcntl.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <malloc.h>
 #include <poll.h>
 #include <signal.h>
 #include <stdarg.h>
@@ -13,17 +17,19 @@
 #include <termios.h>
 #include <unistd.h>
 
+#include "probe.h"
 #include "trex.h"
 #include "tui.h"
+#include "wire.h"
 
 /* Forward declarations */
 static void apply_attributes(int attr);
 static int safe_full_write(int fd, const void *buf, size_t count);
 static int allocate_buffers(void);
 static void init_hierarchical_dirty_tracking(int screen_cols, int screen_rows);
-static void init_back_buffer(size_t rows, size_t cols);
+static void init_back_buffer(size_t *offset, size_t rows);
 static void free_back_buffer(void);
-static bool back_buffer_row_changed(int row);
+static void back_buffer_forget_row(int row);
 
 tui_window_t *tui_stdscr = NULL;
 static int tui_lines = 0;
@@ -38,6 +44,25 @@ static volatile sig_atomic_t g_shutdown_requested = 0;
 /* Signal-safe resize handling */
 static volatile sig_atomic_t g_resize_requested = 0;
 
+/* Active output backend */
+static tui_backend_t g_backend = TUI_BACKEND_VT;
+
+/* Size caches for many concurrent sessions rather than for speed */
+static bool g_lean = false;
+
+/* Buffers and caches were released by tui_hibernate() */
+static bool g_hibernating = false;
+
+/* Terminal output, /dev/null for the headless backend */
+static int g_out_fd = STDOUT_FILENO;
+static int g_headless_rows = 24, g_headless_cols = 80;
+
+/* Called after the screen buffers were reallocated for a new size */
+static void (*g_resize_hook)(void) = NULL;
+
+/* Called before re-raising a shutdown signal, atexit() handlers won't run */
+static void (*g_shutdown_hook)(void) = NULL;
+
 /* Terminal capabilities cache */
 static tui_term_caps_t g_terminal_caps = {0};
 static bool g_caps_loaded = false, g_caps_initialized = false;
@@ -59,14 +84,19 @@ static color_mode_t g_color_mode = COLOR_MODE_16;
 /* Data storage for vectors - ensures data lifetime */
 #define WRITEV_DATA_POOL_SIZE 8192
 
+/* Output buffer sizes in lean mode, more flushes for less memory */
+#define LEAN_OUTPUT_SIZE 2048
+
 typedef struct {
     struct iovec vecs[MAX_IOVECS];
     int count;
     size_t total_bytes;
     bool auto_flush_enabled;
-    /* Data pool to store copied data */
-    char data_pool[WRITEV_DATA_POOL_SIZE];
+    /* Data pool to store copied data, allocated by reserve_output() */
+    char *data_pool;
+    size_t data_pool_size;
     size_t data_pool_used;
+    size_t flush_bytes; /* Auto-flush threshold */
 } writev_buffer_t;
 
 static writev_buffer_t writev_buf = {
@@ -85,39 +115,64 @@ static struct {
     uint64_t partial_writes;
 } writev_stats = {0};
 
-/* Back-buffer system for frame differencing optimization */
+/* Terminal output counters, see tui_get_stats() */
+static struct {
+    uint64_t writes;
+    uint64_t bytes;
+    uint64_t dirty_cells;
+} output_stats = {0};
+
+/* Back buffer: what the terminal shows, each row as sorted spans of identical
+ * cells. Most rows of a frame are sky, ground bands and blank borders, so two
+ * rows compare in time proportional to the scene rather than to the terminal
+ * width, and a long span leaves as a single REP or ECH.
+ */
+#define SPAN_ROW_MAX 48          /* Busier rows are diffed cell by cell */
+#define SPAN_STALE UINT16_MAX    /* Row is read again from the prev buffers */
+#define SPAN_REP_MIN 8           /* Shorter runs are cheaper as plain text */
+#define SPAN_GAP_MAX 3           /* Unchanged cells rewritten to save a move */
+
+typedef struct {
+    uint16_t start, len;
+    int attr;
+    char ch;
+} cell_span_t;
+
 typedef struct {
-    uint16_t *glyph_indices; /* Compact glyph representation */
-    bool *row_dirty_flags;   /* Per-row change tracking */
-    size_t rows, cols;
-    uint64_t row_comparisons; /* Stats: row comparison operations */
-    uint64_t rows_compared;   /* Stats: total rows compared */
-    uint64_t rows_changed;    /* Stats: rows with changes */
-    uint64_t cells_skipped;   /* cells skipped due to row-level optimization */
+    cell_span_t *spans; /* SPAN_ROW_MAX per row, NULL in lean mode */
+    cell_span_t *next;  /* Spans of the row being refreshed */
+    uint16_t *counts;   /* Spans per row or SPAN_STALE */
+    size_t rows;
+    uint64_t rows_compared; /* Stats: rows diffed span by span */
+    uint64_t rows_changed;  /* Stats: rows with changes */
+    uint64_t rows_complex;  /* Stats: rows diffed cell by cell */
 } back_buffer_t;
 
 static back_buffer_t back_buffer = {0};
 
 /* Fallback buffering for compatibility */
-#define OUTPUT_BUFFER_SIZE 8192
-#define BUFFER_FLUSH_THRESHOLD (OUTPUT_BUFFER_SIZE * 3 / 4) /* Flush at 75% */
+#define OUTPUT_BUFFER_SIZE 8192 /* Flushed at 75% */
 static struct {
-    char data[OUTPUT_BUFFER_SIZE];
+    char *data; /* Allocated by reserve_output() */
+    size_t size;
     size_t len;
     bool auto_flush_enabled;
     bool use_writev;
 } output_buffer = {.len = 0, .auto_flush_enabled = true, .use_writev = true};
 
-/* Cursor position caching */
+/* Cursor position caching, sized from the terminal (up to the limits below)
+ * and filled as positions are first used. Lean mode formats every move.
+ */
 #define CURSOR_CACHE_ROWS 100
 #define CURSOR_CACHE_COLS 200
+#define CURSOR_SEQ_LEN 16
 static struct {
-    char sequences[CURSOR_CACHE_ROWS][CURSOR_CACHE_COLS][16];
-    int lengths[CURSOR_CACHE_ROWS][CURSOR_CACHE_COLS];
-    bool initialized;
+    char (*sequences)[CURSOR_SEQ_LEN]; /* rows * cols, from the arena */
+    uint8_t *lengths;                  /* 0 until formatted */
+    int rows, cols;
     int last_row;
     int last_col;
-} cursor_cache = {.initialized = false, .last_row = -1, .last_col = -1};
+} cursor_cache = {.last_row = -1, .last_col = -1};
 
 /* Hierarchical dirty region tracking with 2-level tile system */
 #define TILE_L1_SIZE 8     /* Level 1: 8x8 character tiles */
@@ -133,8 +188,9 @@ typedef struct dirty_tile {
     struct dirty_tile *next;
 } dirty_tile_t;
 
-#define DIRTY_TILE_POOL_SIZE 512
-static dirty_tile_t dirty_tile_pool[DIRTY_TILE_POOL_SIZE];
+/* Sized for every L1 tile and L2 block at once, so it cannot run dry */
+static dirty_tile_t *dirty_tile_pool = NULL;
+static int dirty_tile_pool_size = 0;
 static dirty_tile_t *dirty_tile_free_list = NULL;
 static dirty_tile_t *dirty_l1_tiles = NULL;
 static dirty_tile_t *dirty_l2_blocks = NULL;
@@ -151,12 +207,12 @@ static struct {
     int min_col, max_col;
     bool has_changes;
 
-    /* Level 1: 8x8 tiles for fine-grained tracking */
-    bool l1_tiles[MAX_L1_TILES_Y][MAX_L1_TILES_X];
+    /* Level 1: 8x8 tiles for fine-grained tracking, row-major */
+    bool *l1_tiles;
     int l1_tiles_x, l1_tiles_y;
 
-    /* Level 2: 32x32 blocks for coarse-grained tracking */
-    bool l2_blocks[MAX_L2_BLOCKS_Y][MAX_L2_BLOCKS_X];
+    /* Level 2: 32x32 blocks for coarse-grained tracking, row-major */
+    bool *l2_blocks;
     int l2_blocks_x, l2_blocks_y;
 
     /* Optimization flags */
@@ -264,6 +320,10 @@ static color_pair_t color_pairs[TUI_COLOR_PAIRS];
 #define ESC_SEQ_HASH_SIZE 512      /* Increased for less collisions */
 #define ATTR_COMBO_CACHE_SIZE 1024 /* Increased for more combinations */
 
+/* Pool sizes in lean mode, allocated on the first miss */
+#define ESC_SEQ_LEAN_POOL_SIZE 128
+#define ATTR_COMBO_LEAN_POOL_SIZE 64
+
 /* Pre-computed sequence pools */
 #define CURSOR_POS_POOL_SIZE 256 /* Pool for common cursor positions */
 #define COLOR_SEQ_POOL_SIZE 128  /* Pool for common color sequences */
@@ -313,7 +373,7 @@ static struct {
 
 /* LRU cache for complete escape sequences */
 static struct {
-    esc_lru_entry_t entries[ESC_LRU_CACHE_SIZE];
+    esc_lru_entry_t *entries; /* Not reserved in lean mode */
     esc_lru_entry_t *hash_table[ESC_LRU_HASH_SIZE];
     esc_lru_entry_t *lru_head; /* Most recently used */
     esc_lru_entry_t *lru_tail; /* Least recently used */
@@ -397,10 +457,50 @@ static char **screen_buf = NULL, **prev_screen_buf = NULL;
 static int **attr_buf = NULL, **prev_attr_buf = NULL;
 static int buf_rows = 0, buf_cols = 0;
 
+/* Binary wire backend state (see wire.h) */
+#define WIRE_OUT_PAYLOAD 4096
+#define WIRE_IN_BUFFER_SIZE 1024
+#define WIRE_KEY_QUEUE_SIZE 64
+#define WIRE_HELLO_TIMEOUT_MS 5000
+
+static struct {
+    /* Outgoing span message being assembled: header + payload */
+    uint8_t out[WIRE_HDR_SIZE + WIRE_OUT_PAYLOAD];
+    size_t out_len;
+
+    /* Incoming client messages */
+    uint8_t in[WIRE_IN_BUFFER_SIZE];
+    size_t in_len;
+    int keys[WIRE_KEY_QUEUE_SIZE];
+    int key_head, key_tail;
+    int pending_rows, pending_cols;
+
+    /* Palette entries the client has not seen yet */
+    uint64_t color_dirty[MAX_CUSTOM_COLORS / 64];
+    uint64_t pair_dirty[TUI_COLOR_PAIRS / 64];
+
+    /* Statistics */
+    uint64_t frames;
+    uint64_t spans;
+    uint64_t fill_spans;
+    uint64_t cells;
+} wire = {0};
+
 /* Static buffers for common escape sequences */
 static const char ESC_RESET[] = "\x1b[0m";
 static const char ESC_HIDE_CURSOR[] = "\x1b[?25l";
 static const char ESC_SHOW_CURSOR[] = "\x1b[?25h";
+static const char ESC_SYNC_BEGIN[] = "\x1b[?2026h";
+static const char ESC_SYNC_END[] = "\x1b[?2026l";
+
+/* A frame that changes anything is bracketed as one synchronized update, so
+ * the terminal never shows it half drawn and a reader of the stream can tell
+ * where it ends. The update is opened by the first cursor move of a refresh.
+ */
+static struct {
+    bool armed; /* Refresh in progress, update not opened yet */
+    bool open;
+} frame_sync;
 
 /* Fast access macros for pre-computed sequences */
 #define PRECOMP_RESET (esc_seq_cache.precomputed.attributes[0])
@@ -415,6 +515,7 @@ static void free_color_pair_cache(void);
 /* Forward declarations for string interning */
 static void init_esc_seq_cache(void);
 static void free_esc_seq_cache(void);
+static void *esc_pool_reserve(void **pool, int *size, size_t entry_size);
 static const char *intern_esc_sequence(const char *seq, int len);
 static const char *get_cached_attr_sequence(short fg,
                                             short bg,
@@ -444,6 +545,16 @@ static void output_buffered_run(int y,
 /* Fast background clear with ECH optimization */
 static void tui_clear_fast(void);
 
+/* Forward declarations for the binary wire backend */
+static void wire_wait_for_client(void);
+static void wire_send_hello(void);
+static void wire_send_message(wire_msg_type_t type,
+                              const uint8_t *payload,
+                              size_t len);
+static int wire_getch(void);
+static bool wire_has_input(void);
+static int wire_refresh(void);
+
 /* Fast row-level dirty checking using memcmp */
 static inline bool row_has_changes(int y, int start_col, int end_col)
 {
@@ -720,6 +831,8 @@ static int tui_term_caps_detect(uint32_t timeout_ms)
     g_terminal_caps.supports_ech =
         !is_basic_term && g_terminal_caps.supports_256_colors;
     g_terminal_caps.supports_rep = g_terminal_caps.supports_256_colors;
+    /* Terminals that do not know the mode ignore it */
+    g_terminal_caps.supports_sync = g_terminal_caps.supports_ech;
 
     /* Advanced features */
     g_terminal_caps.supports_wide_chars = g_terminal_caps.supports_unicode;
@@ -863,6 +976,8 @@ static int safe_full_write(int fd, const void *buf, size_t count)
         if (n == 0) /* should never happen on tty */
             return -1;
 
+        output_stats.writes++;
+        output_stats.bytes += n;
         ptr += n;
         remaining -= n;
     }
@@ -885,6 +1000,9 @@ static int safe_full_writev(int fd, struct iovec *restrict iov, int iovcnt)
         if (n == 0) /* should never happen on tty */
             return -1;
 
+        output_stats.writes++;
+        output_stats.bytes += n;
+
         /* Track partial writes for statistics */
         ssize_t total_remaining = 0;
         for (int i = 0; i < iovcnt; i++)
@@ -906,10 +1024,12 @@ static void tui_flush_vectored(void)
     writev_stats.total_vectors += writev_buf.count;
     writev_stats.total_bytes += writev_buf.total_bytes;
 
-    if (safe_full_writev(STDOUT_FILENO, writev_buf.vecs, writev_buf.count) <
-        0) {
+    PROBE2(flush, writev_buf.total_bytes, writev_buf.count);
+    TRACE_BEGIN("writev");
+    if (safe_full_writev(g_out_fd, writev_buf.vecs, writev_buf.count) < 0) {
         writev_stats.fallback_writes++; /* count hard failure */
     }
+    TRACE_END("writev");
 
     /* Reset buffer */
     writev_buf.count = 0;
@@ -926,7 +1046,10 @@ static void tui_flush(void)
 
     /* Fallback implementation */
     if (output_buffer.len > 0) {
-        safe_full_write(STDOUT_FILENO, output_buffer.data, output_buffer.len);
+        PROBE2(flush, output_buffer.len, 1);
+        TRACE_BEGIN("write");
+        safe_full_write(g_out_fd, output_buffer.data, output_buffer.len);
+        TRACE_END("write");
         output_buffer.len = 0;
     }
 }
@@ -935,8 +1058,14 @@ static void tui_write_vectored(const char *data, size_t len)
 {
     /* If we're at vector capacity or data pool is full, flush first */
     if (writev_buf.count >= MAX_IOVECS ||
-        writev_buf.data_pool_used + len > WRITEV_DATA_POOL_SIZE) {
+        writev_buf.data_pool_used + len > writev_buf.data_pool_size) {
         tui_flush_vectored();
+
+        /* Too large for the pool, write it directly */
+        if (len > writev_buf.data_pool_size) {
+            safe_full_write(g_out_fd, data, len);
+            return;
+        }
     }
 
     /* Copy data into our pool to ensure lifetime */
@@ -953,7 +1082,7 @@ static void tui_write_vectored(const char *data, size_t len)
     /* Auto-flush based on vector count or total bytes */
     if (writev_buf.auto_flush_enabled &&
         (writev_buf.count >= VEC_FLUSH_THRESHOLD ||
-         writev_buf.total_bytes >= WRITEV_BUFFER_SIZE)) {
+         writev_buf.total_bytes >= writev_buf.flush_bytes)) {
         tui_flush_vectored();
     }
 }
@@ -968,12 +1097,12 @@ static void tui_write(const char *data, size_t len)
     /* Fallback buffered implementation */
     writev_stats.fallback_writes++;
 
-    if (output_buffer.len + len > OUTPUT_BUFFER_SIZE) {
+    if (output_buffer.len + len > output_buffer.size) {
         tui_flush();
 
         /* If data is still too large, write directly */
-        if (len > OUTPUT_BUFFER_SIZE) {
-            safe_full_write(STDOUT_FILENO, data, len);
+        if (len > output_buffer.size) {
+            safe_full_write(g_out_fd, data, len);
             return;
         }
     }
@@ -984,7 +1113,7 @@ static void tui_write(const char *data, size_t len)
 
     /* Auto-flush when buffer reaches threshold */
     if (output_buffer.auto_flush_enabled &&
-        output_buffer.len >= BUFFER_FLUSH_THRESHOLD) {
+        output_buffer.len >= output_buffer.size * 3 / 4) {
         tui_flush();
     }
 }
@@ -1020,22 +1149,6 @@ static void tui_putchar(char c)
     tui_write(&c, 1);
 }
 
-static void init_cursor_cache(void)
-{
-    if (cursor_cache.initialized)
-        return;
-
-    /* Pre-compute escape sequences for common screen positions */
-    for (int row = 0; row < CURSOR_CACHE_ROWS; row++) {
-        for (int col = 0; col < CURSOR_CACHE_COLS; col++) {
-            cursor_cache.lengths[row][col] =
-                snprintf(cursor_cache.sequences[row][col], 16, "\x1b[%d;%dH",
-                         row + 1, col + 1);
-        }
-    }
-    cursor_cache.initialized = true;
-}
-
 /* Fast cursor position lookup */
 static inline int get_cursor_pool_index(int row, int col)
 {
@@ -1051,6 +1164,12 @@ static inline int get_cursor_pool_index(int row, int col)
 
 static void tui_move_cached(int row, int col)
 {
+    if (frame_sync.armed) {
+        tui_write(ESC_SYNC_BEGIN, sizeof(ESC_SYNC_BEGIN) - 1);
+        frame_sync.armed = false;
+        frame_sync.open = true;
+    }
+
     /* Skip if already at position */
     if (row == cursor_cache.last_row && col == cursor_cache.last_col)
         return;
@@ -1155,12 +1274,23 @@ static void tui_move_cached(int row, int col)
     }
 
     /* Then try runtime cache for positions within cache bounds */
-    if (cursor_cache.initialized && row >= 0 && row < CURSOR_CACHE_ROWS &&
-        col >= 0 && col < CURSOR_CACHE_COLS) {
-        tui_write(cursor_cache.sequences[row][col],
-                  cursor_cache.lengths[row][col]);
+    if (row >= 0 && row < cursor_cache.rows && col >= 0 &&
+        col < cursor_cache.cols) {
+        int idx = row * cursor_cache.cols + col;
+        if (!cursor_cache.lengths[idx])
+            cursor_cache.lengths[idx] =
+                snprintf(cursor_cache.sequences[idx], CURSOR_SEQ_LEN,
+                         "\x1b[%d;%dH", row + 1, col + 1);
+        tui_write(cursor_cache.sequences[idx], cursor_cache.lengths[idx]);
         esc_seq_stats.cache_hits++;
         esc_seq_stats.total_sequences++;
+    } else if (g_lean) {
+        /* Not worth a pool entry, it is cheap to format again */
+        char buf[32];
+        int len = snprintf(buf, sizeof(buf), "\x1b[%d;%dH", row + 1, col + 1);
+        tui_write(buf, len);
+        esc_seq_stats.cache_misses++;
+        esc_seq_stats.total_sequences++;
     } else {
         /* Fall back to dynamic generation and intern the sequence */
         char buf[32];
@@ -1179,7 +1309,10 @@ static void tui_move_cached(int row, int col)
 static void get_terminal_size(void)
 {
     struct winsize ws;
-    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) {
+    if (g_backend == TUI_BACKEND_HEADLESS) {
+        tui_lines = g_headless_rows;
+        tui_cols = g_headless_cols;
+    } else if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) {
         tui_lines = ws.ws_row;
         tui_cols = ws.ws_col;
     } else {
@@ -1199,21 +1332,22 @@ static void init_sparse_dirty_tracking(void)
 {
     /* Initialize free list */
     dirty_tile_free_list = NULL;
-    for (int i = 0; i < DIRTY_TILE_POOL_SIZE - 1; i++) {
-        dirty_tile_pool[i].next = &dirty_tile_pool[i + 1];
+    for (int i = dirty_tile_pool_size - 1; i >= 0; i--) {
+        dirty_tile_pool[i].next = dirty_tile_free_list;
+        dirty_tile_free_list = &dirty_tile_pool[i];
     }
-    dirty_tile_pool[DIRTY_TILE_POOL_SIZE - 1].next = NULL;
-    dirty_tile_free_list = &dirty_tile_pool[0];
 
     dirty_l1_tiles = dirty_l2_blocks = NULL;
     dirty_tile_pool_used = 0;
+    memset(l1_tile_bitmap, 0, sizeof(l1_tile_bitmap));
+    memset(l2_block_bitmap, 0, sizeof(l2_block_bitmap));
     dirty_region.use_sparse_tracking = true;
 }
 
 /* Sparse tile allocation */
 static dirty_tile_t *alloc_dirty_tile(uint16_t row, uint16_t col)
 {
-    if (!dirty_tile_free_list || dirty_tile_pool_used >= DIRTY_TILE_POOL_SIZE)
+    if (!dirty_tile_free_list || dirty_tile_pool_used >= dirty_tile_pool_size)
         return NULL;
 
     dirty_tile_t *tile = dirty_tile_free_list;
@@ -1300,6 +1434,15 @@ static void reset_sparse_dirty_tracking(void)
     memset(l2_block_bitmap, 0, sizeof(l2_block_bitmap));
 }
 
+/* Only the part of the tile grids covering the screen is in use */
+static void clear_tile_grids(void)
+{
+    memset(dirty_region.l1_tiles, 0,
+           dirty_region.l1_tiles_x * dirty_region.l1_tiles_y * sizeof(bool));
+    memset(dirty_region.l2_blocks, 0,
+           dirty_region.l2_blocks_x * dirty_region.l2_blocks_y * sizeof(bool));
+}
+
 /* Initialize hierarchical tile system */
 static void init_hierarchical_dirty_tracking(int screen_cols, int screen_rows)
 {
@@ -1312,20 +1455,21 @@ static void init_hierarchical_dirty_tracking(int screen_cols, int screen_rows)
     dirty_region.l2_blocks_y = (screen_rows + TILE_L2_SIZE - 1) / TILE_L2_SIZE;
 
     /* Enable hierarchical tracking if dimensions fit within limits */
-    if (dirty_region.l1_tiles_x <= MAX_L1_TILES_X &&
+    if (dirty_region.l1_tiles && dirty_region.l1_tiles_x <= MAX_L1_TILES_X &&
         dirty_region.l1_tiles_y <= MAX_L1_TILES_Y &&
         dirty_region.l2_blocks_x <= MAX_L2_BLOCKS_X &&
         dirty_region.l2_blocks_y <= MAX_L2_BLOCKS_Y) {
         dirty_region.use_hierarchical_tiles = true;
 
         /* Clear both levels */
-        memset(dirty_region.l1_tiles, 0, sizeof(dirty_region.l1_tiles));
-        memset(dirty_region.l2_blocks, 0, sizeof(dirty_region.l2_blocks));
+        clear_tile_grids();
 
         /* Reset statistics */
         dirty_region.l1_scans_avoided = 0;
         dirty_region.l2_scans_avoided = 0;
         dirty_region.total_scans = 0;
+    } else {
+        dirty_region.use_hierarchical_tiles = false;
     }
 }
 
@@ -1379,7 +1523,8 @@ static void mark_dirty(int row, int col)
         int l1_tile_col = col / TILE_L1_SIZE;
         if (l1_tile_row < dirty_region.l1_tiles_y &&
             l1_tile_col < dirty_region.l1_tiles_x) {
-            dirty_region.l1_tiles[l1_tile_row][l1_tile_col] = true;
+            dirty_region.l1_tiles[l1_tile_row * dirty_region.l1_tiles_x +
+                                  l1_tile_col] = true;
 
             /* Also add to sparse tracking if enabled */
             if (dirty_region.use_sparse_tracking)
@@ -1391,7 +1536,8 @@ static void mark_dirty(int row, int col)
         int l2_block_col = col / TILE_L2_SIZE;
         if (l2_block_row < dirty_region.l2_blocks_y &&
             l2_block_col < dirty_region.l2_blocks_x) {
-            dirty_region.l2_blocks[l2_block_row][l2_block_col] = true;
+            dirty_region.l2_blocks[l2_block_row * dirty_region.l2_blocks_x +
+                                   l2_block_col] = true;
 
             /* Also add to sparse tracking if enabled */
             if (dirty_region.use_sparse_tracking)
@@ -1424,7 +1570,7 @@ static void mark_dirty_region(int row1, int col1, int row2, int col2)
              tr <= l1_tile_row2 && tr < dirty_region.l1_tiles_y; tr++) {
             for (int tc = l1_tile_col1;
                  tc <= l1_tile_col2 && tc < dirty_region.l1_tiles_x; tc++) {
-                dirty_region.l1_tiles[tr][tc] = true;
+                dirty_region.l1_tiles[tr * dirty_region.l1_tiles_x + tc] = true;
 
                 /* Also add to sparse tracking if enabled */
                 if (dirty_region.use_sparse_tracking) {
@@ -1443,7 +1589,8 @@ static void mark_dirty_region(int row1, int col1, int row2, int col2)
              br <= l2_block_row2 && br < dirty_region.l2_blocks_y; br++) {
             for (int bc = l2_block_col1;
                  bc <= l2_block_col2 && bc < dirty_region.l2_blocks_x; bc++) {
-                dirty_region.l2_blocks[br][bc] = true;
+                dirty_region.l2_blocks[br * dirty_region.l2_blocks_x + bc] =
+                    true;
 
                 /* Also add to sparse tracking if enabled */
                 if (dirty_region.use_sparse_tracking)
@@ -1462,10 +1609,8 @@ static void reset_dirty_region(void)
     dirty_region.has_changes = false;
 
     /* Reset hierarchical tile system */
-    if (dirty_region.use_hierarchical_tiles) {
-        memset(dirty_region.l1_tiles, 0, sizeof(dirty_region.l1_tiles));
-        memset(dirty_region.l2_blocks, 0, sizeof(dirty_region.l2_blocks));
-    }
+    if (dirty_region.use_hierarchical_tiles)
+        clear_tile_grids();
 
     /* Reset sparse tracking */
     if (dirty_region.use_sparse_tracking) {
@@ -1481,7 +1626,8 @@ static inline bool has_l1_tile_changes(int tile_row, int tile_col)
 
     return (tile_row < dirty_region.l1_tiles_y &&
             tile_col < dirty_region.l1_tiles_x &&
-            dirty_region.l1_tiles[tile_row][tile_col]);
+            dirty_region.l1_tiles[tile_row * dirty_region.l1_tiles_x +
+                                  tile_col]);
 }
 
 static inline bool has_l2_block_changes(int block_row, int block_col)
@@ -1491,7 +1637,8 @@ static inline bool has_l2_block_changes(int block_row, int block_col)
 
     return (block_row < dirty_region.l2_blocks_y &&
             block_col < dirty_region.l2_blocks_x &&
-            dirty_region.l2_blocks[block_row][block_col]);
+            dirty_region.l2_blocks[block_row * dirty_region.l2_blocks_x +
+                                   block_col]);
 }
 
 /* Future optimization: quadtree-like region subdivision for very sparse updates
@@ -1625,9 +1772,6 @@ static void scan_l1_tile(int tile_row,
                 x++;
             }
         }
-
-        /* Update back-buffer tracking for this row */
-        back_buffer_row_changed(y);
     }
 }
 
@@ -1738,6 +1882,8 @@ bool tui_check_shutdown(void)
     if (g_shutdown_requested) {
         int sig = g_shutdown_requested;
         restore_terminal();
+        if (g_shutdown_hook)
+            g_shutdown_hook();
         signal(sig, SIG_DFL);
         raise(sig);
         /* will not be reached but included for completeness */
@@ -1748,57 +1894,71 @@ bool tui_check_shutdown(void)
 
 static void handle_terminal_resize(void)
 {
-    struct winsize ws;
+    int rows, cols;
 
-    /* Use ioctl(TIOCGWINSZ) once as recommended by community Q&A */
-    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) {
-        /* Protect against tiny windows that could cause crashes */
-        int new_lines = (ws.ws_row < 3) ? 3 : ws.ws_row;
-        int new_cols = (ws.ws_col < 10) ? 10 : ws.ws_col;
-
-        tui_lines = new_lines;
-        tui_cols = new_cols;
-
-        /* Update window size */
-        if (tui_stdscr) {
-            tui_stdscr->maxy = tui_lines;
-            tui_stdscr->maxx = tui_cols;
-        }
-
-        /* Reallocate all internal TUI buffers for new window size */
-        if (allocate_buffers() == -1) {
-            /* If reallocation fails, try to restore to a safe state */
-            fprintf(stderr,
-                    "Warning: Failed to reallocate buffers after resize\n");
-        }
-
-        /* Reinitialize hierarchical dirty tracking for new screen size */
-        init_hierarchical_dirty_tracking(tui_cols, tui_lines);
-
-        /* Realloc dirty buffer for new window size */
-        if (tui_stdscr && tui_stdscr->dirty) {
-            int new_dirty_size = tui_lines;
-            unsigned char *new_dirty =
-                realloc(tui_stdscr->dirty, new_dirty_size);
-            if (new_dirty) {
-                tui_stdscr->dirty = new_dirty;
-                /* Initialize new dirty areas to require redraw */
-                memset(tui_stdscr->dirty, 1, new_dirty_size);
-            }
-        }
+    if (g_backend == TUI_BACKEND_WIRE) {
+        /* The remote client reports its own terminal size */
+        rows = wire.pending_rows;
+        cols = wire.pending_cols;
+    } else {
+        /* Use ioctl(TIOCGWINSZ) once as recommended by community Q&A */
+        struct winsize ws;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0)
+            return;
+        rows = ws.ws_row;
+        cols = ws.ws_col;
+    }
 
-        /* Force a complete redraw */
-        if (tui_stdscr) {
-            tui_clear_window(tui_stdscr);
-            tui_refresh(tui_stdscr);
-        }
+    /* Protect against tiny windows that could cause crashes */
+    tui_lines = (rows < 3) ? 3 : rows;
+    tui_cols = (cols < 10) ? 10 : cols;
+
+    /* Update window size */
+    if (tui_stdscr) {
+        tui_stdscr->maxy = tui_lines;
+        tui_stdscr->maxx = tui_cols;
+    }
+
+    /* Reallocate all internal TUI buffers for new window size */
+    if (allocate_buffers() == -1) {
+        /* If reallocation fails, try to restore to a safe state */
+        fprintf(stderr, "Warning: Failed to reallocate buffers after resize\n");
+    }
+
+    /* Reinitialize hierarchical dirty tracking for new screen size */
+    init_hierarchical_dirty_tracking(tui_cols, tui_lines);
+    init_sparse_dirty_tracking();
 
-        /* Notify the drawing system to refresh everything */
-        draw_clear_back_buffer();
+    /* Realloc dirty buffer for new window size */
+    if (tui_stdscr && tui_stdscr->dirty) {
+        int new_dirty_size = tui_lines;
+        unsigned char *new_dirty = realloc(tui_stdscr->dirty, new_dirty_size);
+        if (new_dirty) {
+            tui_stdscr->dirty = new_dirty;
+            /* Initialize new dirty areas to require redraw */
+            memset(tui_stdscr->dirty, 1, new_dirty_size);
+        }
+    }
 
-        /* Adjust game object positions for new screen size */
-        play_adjust_for_resize();
+    /* Force a complete redraw */
+    if (tui_stdscr) {
+        tui_clear_window(tui_stdscr);
+        tui_refresh(tui_stdscr);
     }
+
+    /* Let the application refresh everything for the new size */
+    if (g_resize_hook)
+        g_resize_hook();
+}
+
+void tui_set_resize_hook(void (*hook)(void))
+{
+    g_resize_hook = hook;
+}
+
+void tui_set_shutdown_hook(void (*hook)(void))
+{
+    g_shutdown_hook = hook;
 }
 
 bool tui_check_resize(void)
@@ -1822,6 +1982,14 @@ static int setup_terminal(void)
     if (term_initialized)
         return 0;
 
+    /* No local terminal behind these backends, only shutdown signals */
+    if (g_backend != TUI_BACKEND_VT) {
+        signal(SIGINT, handle_signal);
+        signal(SIGTERM, handle_signal);
+        signal(SIGHUP, handle_signal);
+        return 0;
+    }
+
     if (tcgetattr(STDIN_FILENO, &saved_termios) == -1)
         return -1;
 
@@ -1843,32 +2011,81 @@ static int setup_terminal(void)
     return 0;
 }
 
+/* Screen buffers, the cursor cache and the dirty tile grids live in one
+ * grow-only arena sized from the terminal: a resize that fits the reserved
+ * space only re-slices it, so window size changes do not go through the
+ * allocator.
+ */
+static struct {
+    unsigned char *base;
+    size_t size;
+    tui_footprint_t layout; /* screen, cursor and dirty of the current size */
+} buf_arena;
+
+#define TILES(n, size) (((n) + (size) - 1) / (size))
+
+#define ARENA_ALIGN(n) (((n) + 15) & ~(size_t) 15)
+
+/* Hand out the next aligned chunk of the arena */
+static void *arena_slice(size_t *offset, size_t bytes)
+{
+    void *p = buf_arena.base + *offset;
+    *offset += ARENA_ALIGN(bytes);
+    return p;
+}
+
+/* Cursor cache dimensions for a screen, none in lean mode */
+static void cursor_cache_size(size_t rows, size_t cols, int *crows, int *ccols)
+{
+    *crows = g_lean ? 0 : (rows < CURSOR_CACHE_ROWS ? rows : CURSOR_CACHE_ROWS);
+    *ccols = g_lean ? 0 : (cols < CURSOR_CACHE_COLS ? cols : CURSOR_CACHE_COLS);
+}
+
+/* Arena bytes needed for a screen of the given size, see allocate_buffers */
+static size_t arena_bytes(size_t rows, size_t cols, tui_footprint_t *layout)
+{
+    size_t row_arrays = 2 * ARENA_ALIGN(rows * sizeof(char *)) +
+                        2 * ARENA_ALIGN(rows * sizeof(int *));
+    size_t row =
+        2 * ARENA_ALIGN(cols + 1) + 2 * ARENA_ALIGN(cols * sizeof(int));
+    size_t back = g_lean ? 0
+                         : ARENA_ALIGN((rows + 1) * SPAN_ROW_MAX *
+                                       sizeof(cell_span_t)) +
+                               ARENA_ALIGN(rows * sizeof(uint16_t));
+    layout->screen = row_arrays + rows * row + back;
+
+    int crows, ccols;
+    cursor_cache_size(rows, cols, &crows, &ccols);
+    layout->cursor = ARENA_ALIGN(crows * ccols * CURSOR_SEQ_LEN) +
+                     ARENA_ALIGN(crows * ccols);
+
+    size_t l1 = TILES(rows, TILE_L1_SIZE) * TILES(cols, TILE_L1_SIZE);
+    size_t l2 = TILES(rows, TILE_L2_SIZE) * TILES(cols, TILE_L2_SIZE);
+    layout->dirty = ARENA_ALIGN(l1 * sizeof(bool)) +
+                    ARENA_ALIGN(l2 * sizeof(bool)) +
+                    ARENA_ALIGN((l1 + l2) * sizeof(dirty_tile_t));
+
+    return layout->screen + layout->cursor + layout->dirty;
+}
+
 static void free_buffers(void)
 {
-    if (screen_buf) {
-        for (int i = 0; i < buf_rows; i++)
-            free(screen_buf[i]);
-        free(screen_buf);
-        screen_buf = NULL;
-    }
-    if (attr_buf) {
-        for (int i = 0; i < buf_rows; i++)
-            free(attr_buf[i]);
-        free(attr_buf);
-        attr_buf = NULL;
-    }
-    if (prev_screen_buf) {
-        for (int i = 0; i < buf_rows; i++)
-            free(prev_screen_buf[i]);
-        free(prev_screen_buf);
-        prev_screen_buf = NULL;
-    }
-    if (prev_attr_buf) {
-        for (int i = 0; i < buf_rows; i++)
-            free(prev_attr_buf[i]);
-        free(prev_attr_buf);
-        prev_attr_buf = NULL;
-    }
+    free(buf_arena.base);
+    buf_arena.base = NULL;
+    buf_arena.size = 0;
+
+    screen_buf = prev_screen_buf = NULL;
+    attr_buf = prev_attr_buf = NULL;
+    memset(&buf_arena.layout, 0, sizeof(buf_arena.layout));
+
+    cursor_cache.sequences = NULL;
+    cursor_cache.lengths = NULL;
+    cursor_cache.rows = cursor_cache.cols = 0;
+
+    dirty_region.use_hierarchical_tiles = false;
+    dirty_region.l1_tiles = dirty_region.l2_blocks = NULL;
+    dirty_tile_pool = NULL;
+    dirty_tile_pool_size = 0;
 
     /* Free back-buffer system */
     free_back_buffer();
@@ -1879,134 +2096,177 @@ static void free_buffers(void)
 
 static int allocate_buffers(void)
 {
-    free_buffers();
+    tui_footprint_t layout;
+    size_t needed = arena_bytes(tui_lines, tui_cols, &layout);
+
+    if (needed > buf_arena.size) {
+        /* Growing past the reserved buffers is no steady state */
+        alloc_guard_rewarm();
+        free_buffers();
+        buf_arena.base = malloc(needed);
+        if (!buf_arena.base)
+            return -1;
+        buf_arena.size = needed;
+    }
+    buf_arena.layout = layout;
 
     buf_rows = tui_lines;
     buf_cols = tui_cols;
 
-    screen_buf = calloc(buf_rows, sizeof(char *));
-    attr_buf = calloc(buf_rows, sizeof(int *));
-    prev_screen_buf = calloc(buf_rows, sizeof(char *));
-    prev_attr_buf = calloc(buf_rows, sizeof(int *));
-
-    if (!screen_buf || !attr_buf || !prev_screen_buf || !prev_attr_buf) {
-        free_buffers();
-        return -1;
-    }
+    size_t offset = 0;
+    screen_buf = arena_slice(&offset, buf_rows * sizeof(char *));
+    attr_buf = arena_slice(&offset, buf_rows * sizeof(int *));
+    prev_screen_buf = arena_slice(&offset, buf_rows * sizeof(char *));
+    prev_attr_buf = arena_slice(&offset, buf_rows * sizeof(int *));
 
     for (int i = 0; i < buf_rows; i++) {
-        screen_buf[i] = calloc(buf_cols + 1, sizeof(char));
-        attr_buf[i] = calloc(buf_cols, sizeof(int));
-        prev_screen_buf[i] = calloc(buf_cols + 1, sizeof(char));
-        prev_attr_buf[i] = calloc(buf_cols, sizeof(int));
-        if (!screen_buf[i] || !attr_buf[i] || !prev_screen_buf[i] ||
-            !prev_attr_buf[i]) {
-            free_buffers();
-            return -1;
-        }
+        screen_buf[i] = arena_slice(&offset, buf_cols + 1);
+        attr_buf[i] = arena_slice(&offset, buf_cols * sizeof(int));
+        prev_screen_buf[i] = arena_slice(&offset, buf_cols + 1);
+        prev_attr_buf[i] = arena_slice(&offset, buf_cols * sizeof(int));
+
         memset(screen_buf[i], ' ', buf_cols);
-        memset(prev_screen_buf[i], '\0',
-               buf_cols); /* Initialize to different state */
-        memset(prev_attr_buf[i], 0xFF,
-               buf_cols * sizeof(int)); /* Initialize to invalid attrs */
+        screen_buf[i][buf_cols] = '\0';
+        memset(attr_buf[i], 0, buf_cols * sizeof(int));
+        /* Initialize to a different state than the screen */
+        memset(prev_screen_buf[i], '\0', buf_cols + 1);
+        /* Initialize to invalid attrs */
+        memset(prev_attr_buf[i], 0xFF, buf_cols * sizeof(int));
     }
 
     /* Initialize back-buffer system */
-    init_back_buffer(buf_rows, buf_cols);
+    init_back_buffer(&offset, buf_rows);
+
+    /* Cursor sequences are formatted on first use */
+    cursor_cache_size(buf_rows, buf_cols, &cursor_cache.rows,
+                      &cursor_cache.cols);
+    size_t cursor_entries = cursor_cache.rows * cursor_cache.cols;
+    cursor_cache.sequences =
+        arena_slice(&offset, cursor_entries * CURSOR_SEQ_LEN);
+    cursor_cache.lengths = arena_slice(&offset, cursor_entries);
+    memset(cursor_cache.lengths, 0, cursor_entries);
+
+    /* Tile grids, cleared by init_hierarchical_dirty_tracking() */
+    size_t l1 = TILES(buf_rows, TILE_L1_SIZE) * TILES(buf_cols, TILE_L1_SIZE);
+    size_t l2 = TILES(buf_rows, TILE_L2_SIZE) * TILES(buf_cols, TILE_L2_SIZE);
+    dirty_region.l1_tiles = arena_slice(&offset, l1 * sizeof(bool));
+    dirty_region.l2_blocks = arena_slice(&offset, l2 * sizeof(bool));
+    dirty_tile_pool = arena_slice(&offset, (l1 + l2) * sizeof(dirty_tile_t));
+    dirty_tile_pool_size = l1 + l2;
 
     return 0;
 }
 
-/* Back-buffer system implementation */
-static void init_back_buffer(size_t rows, size_t cols)
+/* Back buffer spans, carved from the arena, none in lean mode */
+static void init_back_buffer(size_t *offset, size_t rows)
 {
-    free_back_buffer();
+    if (g_lean) {
+        free_back_buffer();
+        return;
+    }
 
     back_buffer.rows = rows;
-    back_buffer.cols = cols;
+    back_buffer.spans =
+        arena_slice(offset, (rows + 1) * SPAN_ROW_MAX * sizeof(cell_span_t));
+    back_buffer.next = back_buffer.spans + rows * SPAN_ROW_MAX;
+    back_buffer.counts = arena_slice(offset, rows * sizeof(uint16_t));
 
-    back_buffer.glyph_indices = calloc(rows * cols, sizeof(uint16_t));
-    back_buffer.row_dirty_flags = calloc(rows, sizeof(bool));
+    /* Nothing is known about the terminal yet */
+    for (size_t i = 0; i < rows; i++)
+        back_buffer.counts[i] = SPAN_STALE;
 
-    /* Initialize with invalid data to force first frame update */
-    if (back_buffer.glyph_indices)
-        memset(back_buffer.glyph_indices, 0xFF, rows * cols * sizeof(uint16_t));
-
-    /* Reset stats */
-    back_buffer.row_comparisons = 0;
     back_buffer.rows_compared = 0;
     back_buffer.rows_changed = 0;
-    back_buffer.cells_skipped = 0;
+    back_buffer.rows_complex = 0;
 }
 
 static void free_back_buffer(void)
 {
-    if (back_buffer.glyph_indices) {
-        free(back_buffer.glyph_indices);
-        back_buffer.glyph_indices = NULL;
-    }
-    if (back_buffer.row_dirty_flags) {
-        free(back_buffer.row_dirty_flags);
-        back_buffer.row_dirty_flags = NULL;
-    }
-    back_buffer.rows = back_buffer.cols = 0;
+    /* The storage belongs to the arena */
+    back_buffer.spans = back_buffer.next = NULL;
+    back_buffer.counts = NULL;
+    back_buffer.rows = 0;
 }
 
-/* Convert character and attribute to compact glyph index */
-static inline uint16_t char_to_glyph_index(char c, int attr)
+/* The terminal row no longer matches its spans, read it from prev next time */
+static void back_buffer_forget_row(int row)
 {
-    /* Pack 8-bit char + 8-bit simplified attr into 16 bits */
-    uint8_t simplified_attr = (attr & 0xFF); /* Take low 8 bits */
-    return ((uint16_t) (unsigned char) c) | (((uint16_t) simplified_attr) << 8);
+    if (back_buffer.counts && row >= 0 && row < (int) back_buffer.rows)
+        back_buffer.counts[row] = SPAN_STALE;
 }
 
-/* Check if a row has changed using memcmp on glyph indices */
-static bool back_buffer_row_changed(int row)
+/*
+ * Encode a row as spans of identical cells
+ * @cells : Characters of the row
+ * @attrs : Attributes of the row
+ * @cols : Cells in the row
+ * @out : SPAN_ROW_MAX spans
+ *
+ * Returns the number of spans, or -1 if the row needs more than SPAN_ROW_MAX.
+ */
+static int encode_row_spans(const char *cells,
+                            const int *attrs,
+                            int cols,
+                            cell_span_t *out)
 {
-    if (!back_buffer.glyph_indices || row >= (int) back_buffer.rows ||
-        row >= buf_rows || !screen_buf || !attr_buf) {
-        return true; /* Assume changed if not initialized */
-    }
-
-    back_buffer.row_comparisons++;
-    back_buffer.rows_compared++;
+    int n = 0;
 
-    /* Get pointer to back-buffer row */
-    uint16_t *back_row = &back_buffer.glyph_indices[row * back_buffer.cols];
+    for (int x = 0; x < cols;) {
+        char ch = cells[x];
+        int attr = attrs[x];
+        int end = x + 1;
 
-    /* Compare row directly using character and attribute buffers */
-    bool changed = false;
-    size_t effective_cols = (back_buffer.cols < (size_t) buf_cols)
-                                ? back_buffer.cols
-                                : (size_t) buf_cols;
+        while (end < cols && cells[end] == ch && attrs[end] == attr)
+            end++;
+        if (n == SPAN_ROW_MAX)
+            return -1;
 
-    for (size_t col = 0; col < effective_cols; col++) {
-        uint16_t current_glyph =
-            char_to_glyph_index(screen_buf[row][col], attr_buf[row][col]);
-        if (current_glyph != back_row[col]) {
-            changed = true;
-            back_row[col] = current_glyph; /* Update as we go */
-        }
+        out[n].start = x;
+        out[n].len = end - x;
+        out[n].attr = attr;
+        out[n].ch = ch;
+        n++;
+        x = end;
     }
 
-    /* Handle any extra columns beyond buffer width */
-    for (size_t col = effective_cols; col < back_buffer.cols; col++) {
-        uint16_t space_glyph = char_to_glyph_index(' ', 0);
-        if (space_glyph != back_row[col]) {
-            changed = true;
-            back_row[col] = space_glyph;
-        }
-    }
+    return n;
+}
 
-    if (changed) {
-        back_buffer.rows_changed++;
-        back_buffer.row_dirty_flags[row] = true;
-    } else {
-        back_buffer.cells_skipped += back_buffer.cols;
-        back_buffer.row_dirty_flags[row] = false;
+/* Allocate the buffer of the output path in use, it outlives tui_cleanup()
+ * because restore_terminal() still writes at exit
+ */
+static bool reserve_output(void)
+{
+    size_t size = g_lean ? LEAN_OUTPUT_SIZE : 0;
+
+    if (output_buffer.use_writev) {
+        if (writev_buf.data_pool)
+            return true;
+        writev_buf.data_pool_size = size ? size : WRITEV_DATA_POOL_SIZE;
+        writev_buf.flush_bytes = size ? size * 3 / 4 : WRITEV_BUFFER_SIZE;
+        writev_buf.data_pool = malloc(writev_buf.data_pool_size);
+        return writev_buf.data_pool;
     }
 
-    return changed;
+    if (output_buffer.data)
+        return true;
+    output_buffer.size = size ? size : OUTPUT_BUFFER_SIZE;
+    output_buffer.data = malloc(output_buffer.size);
+    return output_buffer.data;
+}
+
+/* Drop the output buffer, writes go straight to the terminal meanwhile */
+static void release_output(void)
+{
+    tui_flush();
+
+    free(writev_buf.data_pool);
+    writev_buf.data_pool = NULL;
+    writev_buf.data_pool_size = 0;
+
+    free(output_buffer.data);
+    output_buffer.data = NULL;
+    output_buffer.size = 0;
 }
 
 /* Test if writev is available and functional */
@@ -2022,7 +2282,7 @@ static void detect_writev_support(void)
     test_vec[1].iov_base = test2;
     test_vec[1].iov_len = 0;
 
-    ssize_t result = writev(STDOUT_FILENO, test_vec, 2);
+    ssize_t result = writev(g_out_fd, test_vec, 2);
 
     /* writev should return 0 for empty vectors, or work normally */
     if (result >= 0) {
@@ -2045,14 +2305,28 @@ tui_window_t *tui_init(void)
     if (tui_stdscr)
         return tui_stdscr;
 
+    /* Encode as usual, but for nobody */
+    if (g_backend == TUI_BACKEND_HEADLESS) {
+        g_out_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+        if (g_out_fd == -1)
+            return NULL;
+    }
+
     /* Load terminal capabilities with caching */
-    load_terminal_capabilities();
+    if (g_backend != TUI_BACKEND_WIRE)
+        load_terminal_capabilities();
 
     /* Test writev support */
     detect_writev_support();
+    if (!reserve_output())
+        return NULL;
 
     get_terminal_size();
 
+    /* Remote clients report their own terminal size */
+    if (g_backend == TUI_BACKEND_WIRE)
+        wire_wait_for_client();
+
     if (setup_terminal() == -1)
         return NULL;
 
@@ -2077,9 +2351,6 @@ tui_window_t *tui_init(void)
         return NULL;
     }
 
-    /* Initialize cursor cache for performance */
-    init_cursor_cache();
-
     /* Initialize hierarchical dirty region tracking */
     init_hierarchical_dirty_tracking(tui_cols, tui_lines);
 
@@ -2095,6 +2366,12 @@ tui_window_t *tui_init(void)
     /* Initialize LRU escape sequence cache */
     init_esc_lru_cache();
 
+    /* Remote clients own their terminal, just tell them about the grid */
+    if (g_backend == TUI_BACKEND_WIRE) {
+        wire_send_hello();
+        return tui_stdscr;
+    }
+
     /* Use alternate screen if supported */
     if (g_terminal_caps.alt_screen) {
         const char *alt_screen_on = tui_get_cap_sequence("alt_screen_on");
@@ -2123,6 +2400,12 @@ int tui_cleanup(void)
     free(tui_stdscr);
     tui_stdscr = NULL;
 
+    if (g_backend == TUI_BACKEND_WIRE) {
+        wire_send_message(WIRE_MSG_BYE, NULL, 0);
+        tui_flush();
+        return 0;
+    }
+
     /* Reset colors and clear screen */
     tui_puts(ESC_RESET);
     tui_clear_fast();
@@ -2144,6 +2427,76 @@ int tui_cleanup(void)
     return 0;
 }
 
+/**
+ * Release the screen buffers and caches of an idle session
+ *
+ * Only the window and the color pair table are kept, and the freed pages are
+ * handed back to the kernel. Nothing may be drawn until tui_wake().
+ */
+void tui_hibernate(void)
+{
+    if (!tui_stdscr || g_hibernating)
+        return;
+
+    tui_flush();
+    free_buffers();
+    free_esc_seq_cache();
+    free_esc_lru_cache();
+    release_output();
+    malloc_trim(0);
+
+    g_hibernating = true;
+}
+
+/* Block until input arrives or a shutdown or resize signal is pending */
+void tui_wait_event(void)
+{
+    sigset_t block, orig;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    sigaddset(&block, SIGHUP);
+    sigaddset(&block, SIGWINCH);
+
+    /* The flags are tested with the signals held back, ppoll() lets them in
+     * atomically, so a signal arriving in between cannot be slept through
+     */
+    sigprocmask(SIG_BLOCK, &block, &orig);
+    struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+    while (!g_shutdown_requested && !g_resize_requested && !tui_has_input())
+        ppoll(&pfd, 1, NULL, &orig);
+    sigprocmask(SIG_SETMASK, &orig, NULL);
+}
+
+/**
+ * Reserve everything tui_hibernate() released
+ *
+ * The previous screen contents are forgotten, so the next refresh repaints
+ * the whole screen. Returns false if the buffers could not be allocated.
+ */
+bool tui_wake(void)
+{
+    if (!g_hibernating)
+        return true;
+
+    /* Waking up allocates, like growing the screen does */
+    alloc_guard_rewarm();
+
+    if (allocate_buffers() == -1 || !reserve_output())
+        return false;
+    g_hibernating = false;
+
+    init_hierarchical_dirty_tracking(tui_cols, tui_lines);
+    init_sparse_dirty_tracking();
+    init_esc_seq_cache();
+    init_esc_lru_cache();
+    reset_cursor_tracking();
+    reset_attr_state();
+
+    tui_clear_window(tui_stdscr);
+    return true;
+}
+
 int tui_start_color(void)
 {
     colors_initialized = 1;
@@ -2218,10 +2571,8 @@ static void init_color_pair_cache(void)
     /* Clear hash table */
     memset(color_pair_cache.table, 0, sizeof(color_pair_cache.table));
 
-    /* Allocate node pool */
+    /* The node pool is allocated on the first pair outside the common ones */
     color_pair_cache.node_count = TUI_COLOR_PAIRS;
-    color_pair_cache.nodes =
-        calloc(color_pair_cache.node_count, sizeof(color_pair_node_t));
     color_pair_cache.node_used = 0;
     color_pair_cache.next_pair = 1;
     color_pair_cache.allocated_count = 0;
@@ -2296,6 +2647,10 @@ static short get_or_alloc_pair(short fg, short bg)
     }
 
     /* Get new node from pool */
+    if (!esc_pool_reserve((void **) &color_pair_cache.nodes,
+                          &color_pair_cache.node_count,
+                          sizeof(color_pair_node_t)))
+        return 0;
     node = &color_pair_cache.nodes[color_pair_cache.node_used++];
     node->fg_bg = fg_bg;
     node->fg = fg;
@@ -2310,6 +2665,7 @@ static short get_or_alloc_pair(short fg, short bg)
     if (node->pair_num < TUI_COLOR_PAIRS) {
         color_pairs[node->pair_num].fg = fg;
         color_pairs[node->pair_num].bg = bg;
+        wire.pair_dirty[node->pair_num / 64] |= 1ULL << (node->pair_num % 64);
     }
 
     color_pair_cache.allocated_count++;
@@ -2358,6 +2714,7 @@ int tui_init_pair(short pair, short fg, short bg)
     /* For compatibility, always update the legacy array */
     color_pairs[pair].fg = fg;
     color_pairs[pair].bg = bg;
+    wire.pair_dirty[pair / 64] |= 1ULL << (pair % 64);
 
     /* Also ensure it's in the lazy allocation cache for consistency */
     if (pair > 0 && pair < 10) {
@@ -2446,21 +2803,14 @@ static void init_esc_seq_cache(void)
     if (esc_seq_cache.initialized)
         return;
 
-    /* Clear hash tables */
-    memset(esc_seq_cache.hash_table, 0, sizeof(esc_seq_cache.hash_table));
-    memset(esc_seq_cache.attr_combo_table, 0,
-           sizeof(esc_seq_cache.attr_combo_table));
+    /* The hash tables start out zeroed, free_esc_seq_cache() clears them */
 
-    /* Allocate escape sequence pool */
-    esc_seq_cache.pool_size = ESC_SEQ_POOL_SIZE;
-    esc_seq_cache.pool =
-        calloc(esc_seq_cache.pool_size, sizeof(esc_seq_entry_t));
+    /* Pools are allocated on the first miss, see esc_pool_reserve() */
+    esc_seq_cache.pool_size = g_lean ? ESC_SEQ_LEAN_POOL_SIZE
+                                     : ESC_SEQ_POOL_SIZE;
     esc_seq_cache.pool_used = 0;
-
-    /* Allocate attribute combination pool */
-    esc_seq_cache.attr_combo_pool_size = ATTR_COMBO_CACHE_SIZE;
-    esc_seq_cache.attr_combo_pool =
-        calloc(esc_seq_cache.attr_combo_pool_size, sizeof(attr_combo_entry_t));
+    esc_seq_cache.attr_combo_pool_size = g_lean ? ATTR_COMBO_LEAN_POOL_SIZE
+                                                : ATTR_COMBO_CACHE_SIZE;
     esc_seq_cache.attr_combo_pool_used = 0;
 
     esc_seq_cache.initialized = true;
@@ -2468,6 +2818,10 @@ static void init_esc_seq_cache(void)
     /* Initialize pre-computed sequences */
     init_precomputed_sequences();
 
+    /* Lean mode only keeps what the game actually draws */
+    if (g_lean)
+        return;
+
     /* Pre-cache common sequences */
     intern_esc_sequence("\x1b[0m", 4);  /* Reset */
     intern_esc_sequence("\x1b[1m", 4);  /* Bold */
@@ -2545,12 +2899,12 @@ static void init_esc_lru_cache(void)
     /* Clear the cache */
     memset(&esc_lru_cache, 0, sizeof(esc_lru_cache));
 
-    /* Initialize all entries */
-    for (int i = 0; i < ESC_LRU_CACHE_SIZE; i++) {
-        esc_lru_cache.entries[i].lru_prev = NULL;
-        esc_lru_cache.entries[i].lru_next = NULL;
-        esc_lru_cache.entries[i].hash_next = NULL;
-        esc_lru_cache.entries[i].key_hash = 0;
+    /* Nothing looks sequences up here yet, so lean mode reserves nothing */
+    if (!g_lean) {
+        esc_lru_cache.entries =
+            calloc(ESC_LRU_CACHE_SIZE, sizeof(esc_lru_entry_t));
+        if (!esc_lru_cache.entries)
+            return;
     }
 
     esc_lru_cache.initialized = true;
@@ -2559,9 +2913,21 @@ static void init_esc_lru_cache(void)
 /* Free LRU escape sequence cache */
 static void free_esc_lru_cache(void)
 {
+    free(esc_lru_cache.entries);
     memset(&esc_lru_cache, 0, sizeof(esc_lru_cache));
 }
 
+/* Allocate a pool on its first use, a failure disables it */
+static void *esc_pool_reserve(void **pool, int *size, size_t entry_size)
+{
+    if (!*pool && *size > 0) {
+        *pool = calloc(*size, entry_size);
+        if (!*pool)
+            *size = 0;
+    }
+    return *pool;
+}
+
 /* Intern an escape sequence - returns pointer to cached copy */
 static const char *intern_esc_sequence(const char *seq, int len)
 {
@@ -2583,7 +2949,9 @@ static const char *intern_esc_sequence(const char *seq, int len)
     }
 
     /* Not found, create new entry if pool has space */
-    if (esc_seq_cache.pool_used >= esc_seq_cache.pool_size)
+    if (esc_seq_cache.pool_used >= esc_seq_cache.pool_size ||
+        !esc_pool_reserve((void **) &esc_seq_cache.pool,
+                          &esc_seq_cache.pool_size, sizeof(esc_seq_entry_t)))
         return seq; /* Pool full, fallback */
 
     entry = &esc_seq_cache.pool[esc_seq_cache.pool_used++];
@@ -2680,9 +3048,15 @@ static const char *get_cached_attr_sequence(short fg,
     /* Intern the sequence */
     const char *interned_seq = intern_esc_sequence(seq_buf, seq_len);
 
-    /* Cache the attribute combination if pool has space */
-    if (esc_seq_cache.attr_combo_pool_used <
-        esc_seq_cache.attr_combo_pool_size) {
+    /* Cache the attribute combination if pool has space, but never a
+     * sequence that only lives in seq_buf because interning failed
+     */
+    if (interned_seq != seq_buf &&
+        esc_seq_cache.attr_combo_pool_used <
+            esc_seq_cache.attr_combo_pool_size &&
+        esc_pool_reserve((void **) &esc_seq_cache.attr_combo_pool,
+                         &esc_seq_cache.attr_combo_pool_size,
+                         sizeof(attr_combo_entry_t))) {
         entry = &esc_seq_cache
                      .attr_combo_pool[esc_seq_cache.attr_combo_pool_used++];
         entry->fg = fg;
@@ -2708,6 +3082,7 @@ int tui_init_color(short color, short r, short g, short b)
         color_defs[color].r = r;
         color_defs[color].g = g;
         color_defs[color].b = b;
+        wire.color_dirty[color / 64] |= 1ULL << (color % 64);
     }
     return 0;
 }
@@ -2749,6 +3124,15 @@ int tui_echo(void)
 int tui_set_cursor(int visibility)
 {
     int prev = cursor_visibility;
+
+    /* The remote client manages its own cursor */
+    if (g_backend == TUI_BACKEND_WIRE) {
+        if (visibility != 0 && visibility != 1)
+            return -1;
+        cursor_visibility = visibility;
+        return prev;
+    }
+
     if (visibility == 0) {
         tui_puts(ESC_HIDE_CURSOR);
         cursor_visibility = 0;
@@ -2799,6 +3183,9 @@ int tui_getch(void)
     if (!tui_stdscr)
         return -1;
 
+    if (g_backend == TUI_BACKEND_WIRE)
+        return wire_getch();
+
     /* Use poll() with 4ms timeout for low-latency input polling
      * as recommended by Dan Luu's terminal latency research.
      * This reduces input latency without pegging a CPU core. */
@@ -2832,6 +3219,9 @@ bool tui_has_input(void)
     if (!tui_stdscr)
         return false;
 
+    if (g_backend == TUI_BACKEND_WIRE)
+        return wire_has_input();
+
     /* Check if input is available using poll() with zero timeout */
     struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
 
@@ -2868,6 +3258,7 @@ int tui_clear_screen(void)
         /* Invalidate previous buffer to force redraw */
         memset(prev_screen_buf[i], '\0', buf_cols);
         memset(prev_attr_buf[i], 0xFF, buf_cols * sizeof(int));
+        back_buffer_forget_row(i);
     }
 
     tui_stdscr->cury = 0;
@@ -2900,6 +3291,11 @@ tui_window_t *tui_newwin(int nlines, int ncols, int begin_y, int begin_x)
     win->attr = TUI_A_NORMAL;
     win->bkgd = TUI_A_NORMAL;
 
+    /* Sub-windows may be drawn from worker threads, so they only record
+     * dirty rows locally and leave the shared dirty region untouched.
+     */
+    win->deferred = true;
+
     win->dirty = calloc(nlines, sizeof(unsigned char));
     if (!win->dirty) {
         free(win);
@@ -2932,10 +3328,8 @@ int tui_clear_window(tui_window_t *win)
                 if (screen_x >= 0 && screen_x < buf_cols) {
                     screen_buf[screen_y][screen_x] = ' ';
                     attr_buf[screen_y][screen_x] = win->bkgd;
-                    /* Invalidate previous buffer to force redraw */
-                    prev_screen_buf[screen_y][screen_x] = '\0';
-                    prev_attr_buf[screen_y][screen_x] = 0xFFFFFFFF;
-                    mark_dirty(screen_y, screen_x);
+                    if (!win->deferred)
+                        mark_dirty(screen_y, screen_x);
                 }
             }
         }
@@ -3002,7 +3396,7 @@ static void output_buffered_run_vectored(int y,
             /* More aggressive batching: flush less frequently to accumulate
              * more vectors */
             if (writev_buf.count >= (VEC_FLUSH_THRESHOLD * 3 / 4) ||
-                writev_buf.total_bytes >= (WRITEV_BUFFER_SIZE * 3 / 4)) {
+                writev_buf.total_bytes >= (writev_buf.flush_bytes * 3 / 4)) {
                 tui_flush_vectored();
             }
         }
@@ -3064,6 +3458,206 @@ static void output_buffered_run(int y,
     rle_stats.total_chars_output += run_len;
 }
 
+/* Emit the changed cells of one row in [min_col, max_col] */
+static void scan_row(int y, int min_col, int max_col, bool *has_changes)
+{
+    if (max_col >= buf_cols)
+        max_col = buf_cols - 1;
+
+    /* Fast row check: skip entire row if unchanged */
+    if (!row_has_changes(y, min_col, max_col))
+        return;
+
+    int x = min_col;
+    while (x <= max_col && x < tui_cols) {
+        /* Check if cell has changed */
+        if (screen_buf[y][x] == prev_screen_buf[y][x] &&
+            attr_buf[y][x] == prev_attr_buf[y][x]) {
+            x++;
+            continue;
+        }
+        *has_changes = true;
+
+        /* Find end of run with same attributes that have changed, with gap
+         * coalescing
+         */
+        int curr_attr = attr_buf[y][x];
+        int end_x = x;
+        int unchanged_gap = 0;
+
+        while (end_x + 1 < buf_cols && end_x + 1 < tui_cols &&
+               attr_buf[y][end_x + 1] == curr_attr) {
+            if (screen_buf[y][end_x + 1] != prev_screen_buf[y][end_x + 1] ||
+                attr_buf[y][end_x + 1] != prev_attr_buf[y][end_x + 1]) {
+                /* Changed cell - continue the run */
+                end_x++;
+                unchanged_gap = 0;
+            } else if (unchanged_gap < SPAN_GAP_MAX) {
+                /* Small gap of unchanged cells - include in run to avoid
+                 * cursor move
+                 */
+                end_x++;
+                unchanged_gap++;
+            } else {
+                /* Gap too large - end the run */
+                break;
+            }
+        }
+
+        /* Trim any trailing unchanged cells */
+        while (end_x > x && screen_buf[y][end_x] == prev_screen_buf[y][end_x] &&
+               attr_buf[y][end_x] == prev_attr_buf[y][end_x])
+            end_x--;
+
+        tui_move_cached(y, x);
+        apply_attributes(curr_attr);
+        output_buffered_run(y, x, end_x, screen_buf, prev_screen_buf,
+                            prev_attr_buf);
+        cursor_cache.last_col = end_x + 1;
+
+        x = end_x + 1;
+    }
+}
+
+/*
+ * Write cells [x, end) of a row from its spans
+ * @y : Screen row
+ * @x : First cell to write
+ * @end : Cell after the last one to write
+ * @span : Span of the row that holds @x
+ * @cols : Width of the row
+ *
+ * Each span becomes plain text, or one REP when it is long. A blank run that
+ * reaches the end of the row is erased with ECH, which leaves the cursor where
+ * the run starts.
+ */
+static void emit_span_cells(int y,
+                            int x,
+                            int end,
+                            const cell_span_t *span,
+                            int cols)
+{
+    static char text[256];
+    int len = 0, attr = span->attr;
+
+    tui_move_cached(y, x);
+    apply_attributes(attr);
+
+    memcpy(prev_screen_buf[y] + x, screen_buf[y] + x, end - x);
+    memcpy(prev_attr_buf[y] + x, attr_buf[y] + x, (end - x) * sizeof(int));
+    rle_stats.total_chars_output += end - x;
+    cursor_cache.last_col = end;
+
+    for (; x < end; span++) {
+        int run_end = span->start + span->len < end ? span->start + span->len
+                                                    : end;
+        int n = run_end - x;
+        bool rep = n >= SPAN_REP_MIN && g_terminal_caps.supports_rep &&
+                   span->ch >= ' ' && span->ch <= '~';
+        bool ech = n >= SPAN_REP_MIN && run_end == cols && span->ch == ' ' &&
+                   g_terminal_caps.supports_ech &&
+                   !(span->attr & (TUI_A_REVERSE | TUI_A_UNDERLINE));
+
+        if (len && (span->attr != attr || rep || ech ||
+                    len + n > (int) sizeof(text))) {
+            tui_write(text, len);
+            len = 0;
+        }
+        if (span->attr != attr) {
+            attr = span->attr;
+            apply_attributes(attr);
+        }
+
+        char seq[16];
+        if (ech) {
+            tui_write(seq, snprintf(seq, sizeof(seq), "\x1b[%dX", n));
+            cursor_cache.last_col = x;
+            rle_stats.space_runs_optimized++;
+            rle_stats.space_chars_saved += n;
+        } else if (rep) {
+            tui_putchar(span->ch);
+            tui_write(seq, snprintf(seq, sizeof(seq), "\x1b[%db", n - 1));
+            rle_stats.char_runs_optimized++;
+            rle_stats.char_repeats_saved += n;
+        } else if (n > (int) sizeof(text)) {
+            for (int i = 0; i < n; i++)
+                tui_putchar(span->ch);
+        } else {
+            memset(text + len, span->ch, n);
+            len += n;
+        }
+        x = run_end;
+    }
+
+    if (len)
+        tui_write(text, len);
+}
+
+/*
+ * Diff a row against the back buffer and emit the cells that changed
+ * @y : Screen row
+ * @has_changes : Set if anything was written
+ *
+ * Both rows are walked as spans, so a row of sky costs a few comparisons no
+ * matter how wide the terminal is. Rows with more than SPAN_ROW_MAX spans go
+ * through scan_row() instead.
+ */
+static void diff_row_spans(int y, bool *has_changes)
+{
+    int cols = buf_cols < tui_cols ? buf_cols : tui_cols;
+    cell_span_t *shown = back_buffer.spans + (size_t) y * SPAN_ROW_MAX;
+    const cell_span_t *cur = back_buffer.next;
+    int nshown = back_buffer.counts[y];
+    int ncur = encode_row_spans(screen_buf[y], attr_buf[y], cols,
+                                back_buffer.next);
+
+    if (nshown == SPAN_STALE)
+        nshown = encode_row_spans(prev_screen_buf[y], prev_attr_buf[y], cols,
+                                  shown);
+    if (nshown < 0 || ncur < 0) {
+        back_buffer.rows_complex++;
+        scan_row(y, 0, cols - 1, has_changes);
+        if (ncur >= 0)
+            memcpy(shown, cur, ncur * sizeof(cell_span_t));
+        back_buffer.counts[y] = ncur >= 0 ? ncur : SPAN_STALE;
+        return;
+    }
+    back_buffer.rows_compared++;
+
+    /* Changed intervals, those a few cells apart are merged */
+    int first = -1, first_span = 0, last = 0;
+    for (int i = 0, j = 0, x = 0; x < cols;) {
+        int cur_end = cur[i].start + cur[i].len;
+        int shown_end = shown[j].start + shown[j].len;
+        int end = cur_end < shown_end ? cur_end : shown_end;
+
+        if (cur[i].ch != shown[j].ch || cur[i].attr != shown[j].attr) {
+            if (first >= 0 && x - last > SPAN_GAP_MAX) {
+                emit_span_cells(y, first, last, cur + first_span, cols);
+                first = -1;
+            }
+            if (first < 0) {
+                first = x;
+                first_span = i;
+            }
+            last = end;
+        }
+
+        x = end;
+        i += cur_end == end;
+        j += shown_end == end;
+    }
+
+    if (first >= 0) {
+        emit_span_cells(y, first, last, cur + first_span, cols);
+        back_buffer.rows_changed++;
+        *has_changes = true;
+    }
+
+    memcpy(shown, cur, ncur * sizeof(cell_span_t));
+    back_buffer.counts[y] = ncur;
+}
+
 static void apply_attributes(int attr)
 {
     /* Extract color information */
@@ -3184,11 +3778,456 @@ static void tui_clear_fast(void)
     }
 }
 
-int tui_refresh(tui_window_t *win)
+/* Binary wire backend
+ *
+ * Instead of VT bytes the server emits the cells that changed since the
+ * last frame as run-length spans. Palette entries are sent lazily the first
+ * time they are defined or changed, so the client can resolve attributes
+ * against its own color tables.
+ */
+
+int tui_set_backend(tui_backend_t backend)
+{
+    /* The backend cannot change once the screen is set up */
+    if (tui_stdscr)
+        return -1;
+
+    g_backend = backend;
+    return 0;
+}
+
+/**
+ * Set the screen size used by the headless backend
+ * @rows : Screen lines
+ * @cols : Screen columns
+ */
+void tui_set_headless_size(int rows, int cols)
+{
+    g_headless_rows = rows < 3 ? 3 : rows;
+    g_headless_cols = cols < 10 ? 10 : cols;
+}
+
+/* Trade cache hit rates for a smaller footprint, call before tui_init() */
+void tui_set_lean(bool lean)
+{
+    g_lean = lean;
+}
+
+static void wire_send_message(wire_msg_type_t type,
+                              const uint8_t *payload,
+                              size_t len)
+{
+    uint8_t hdr[WIRE_HDR_SIZE];
+    wire_put_hdr(hdr, type, len);
+    tui_write((const char *) hdr, sizeof(hdr));
+    if (len)
+        tui_write((const char *) payload, len);
+}
+
+static void wire_flush_spans(void)
+{
+    if (!wire.out_len)
+        return;
+
+    wire_put_hdr(wire.out, WIRE_MSG_SPANS, wire.out_len);
+    tui_write((const char *) wire.out, WIRE_HDR_SIZE + wire.out_len);
+    wire.out_len = 0;
+}
+
+/* Reserve room for a span, flushing the current message when full */
+static uint8_t *wire_reserve(size_t len)
+{
+    if (wire.out_len + len > WIRE_OUT_PAYLOAD)
+        wire_flush_spans();
+
+    uint8_t *p = wire.out + WIRE_HDR_SIZE + wire.out_len;
+    wire.out_len += len;
+    return p;
+}
+
+static inline uint32_t wire_cell_at(int y, int x)
+{
+    return wire_pack_cell(screen_buf[y][x], attr_buf[y][x]);
+}
+
+static void wire_emit_fill(int y, int x, int count, uint32_t cell)
+{
+    while (count > 0) {
+        int n = count < WIRE_SPAN_MAX_CELLS ? count : WIRE_SPAN_MAX_CELLS;
+        uint8_t *p = wire_reserve(WIRE_SPAN_HDR_SIZE + WIRE_CELL_SIZE);
+        wire_put16(p, y);
+        wire_put16(p + 2, x);
+        wire_put16(p + 4, n | WIRE_SPAN_FILL);
+        wire_put32(p + 6, cell);
+
+        wire.spans++;
+        wire.fill_spans++;
+        wire.cells += n;
+        x += n;
+        count -= n;
+    }
+}
+
+static void wire_emit_literal(int y, int x, int count)
+{
+    while (count > 0) {
+        /* Compare before subtracting, the size_t difference would wrap */
+        if (wire.out_len + WIRE_SPAN_HDR_SIZE + WIRE_CELL_SIZE >
+            WIRE_OUT_PAYLOAD) {
+            wire_flush_spans();
+            continue;
+        }
+
+        int room = (WIRE_OUT_PAYLOAD - wire.out_len - WIRE_SPAN_HDR_SIZE) /
+                   WIRE_CELL_SIZE;
+        int n = count < room ? count : room;
+        uint8_t *p = wire_reserve(WIRE_SPAN_HDR_SIZE + n * WIRE_CELL_SIZE);
+        wire_put16(p, y);
+        wire_put16(p + 2, x);
+        wire_put16(p + 4, n);
+        p += WIRE_SPAN_HDR_SIZE;
+        for (int i = 0; i < n; i++, p += WIRE_CELL_SIZE)
+            wire_put32(p, wire_cell_at(y, x + i));
+
+        wire.spans++;
+        wire.cells += n;
+        x += n;
+        count -= n;
+    }
+}
+
+/* Length of the run of identical cells starting at x, bounded by end_x */
+static int wire_run_length(int y, int x, int end_x)
+{
+    uint32_t cell = wire_cell_at(y, x);
+    int run = 1;
+    while (x + run <= end_x && wire_cell_at(y, x + run) == cell)
+        run++;
+    return run;
+}
+
+/* Encode a run of changed cells as fill spans and literal spans */
+static void wire_encode_run(int y, int start_x, int end_x)
+{
+    int x = start_x;
+    while (x <= end_x) {
+        int run = wire_run_length(y, x, end_x);
+        if (run >= WIRE_FILL_MIN_RUN) {
+            wire_emit_fill(y, x, run, wire_cell_at(y, x));
+            x += run;
+            continue;
+        }
+
+        /* Extend the literal until a run worth filling begins */
+        int lit_end = x + run;
+        while (lit_end <= end_x) {
+            int next = wire_run_length(y, lit_end, end_x);
+            if (next >= WIRE_FILL_MIN_RUN)
+                break;
+            lit_end += next;
+        }
+
+        wire_emit_literal(y, x, lit_end - x);
+        x = lit_end;
+    }
+
+    /* The client now holds these cells */
+    for (x = start_x; x <= end_x; x++) {
+        prev_screen_buf[y][x] = screen_buf[y][x];
+        prev_attr_buf[y][x] = attr_buf[y][x];
+    }
+}
+
+/* Send color and pair definitions the client has not seen yet */
+static bool wire_sync_palette(void)
+{
+    bool sent = false;
+    uint8_t payload[8];
+
+    for (int w = 0; w < MAX_CUSTOM_COLORS / 64; w++) {
+        while (wire.color_dirty[w]) {
+            int bit = __builtin_ctzll(wire.color_dirty[w]);
+            int color = w * 64 + bit;
+            wire.color_dirty[w] &= wire.color_dirty[w] - 1;
+
+            wire_put16(payload, color);
+            wire_put16(payload + 2, color_defs[color].r);
+            wire_put16(payload + 4, color_defs[color].g);
+            wire_put16(payload + 6, color_defs[color].b);
+            wire_send_message(WIRE_MSG_COLOR, payload, 8);
+            sent = true;
+        }
+    }
+
+    for (int w = 0; w < TUI_COLOR_PAIRS / 64; w++) {
+        while (wire.pair_dirty[w]) {
+            int bit = __builtin_ctzll(wire.pair_dirty[w]);
+            int pair = w * 64 + bit;
+            wire.pair_dirty[w] &= wire.pair_dirty[w] - 1;
+
+            wire_put16(payload, pair);
+            wire_put16(payload + 2, color_pairs[pair].fg);
+            wire_put16(payload + 4, color_pairs[pair].bg);
+            wire_send_message(WIRE_MSG_PAIR, payload, 6);
+            sent = true;
+        }
+    }
+
+    return sent;
+}
+
+static int wire_refresh(void)
+{
+    TRACE_BEGIN("diff");
+    bool has_changes = wire_sync_palette();
+
+    if (dirty_region.has_changes)
+        optimize_dirty_region();
+
+    if (dirty_region.has_changes) {
+        int min_row = dirty_region.min_row > 0 ? dirty_region.min_row : 0;
+        int max_row = dirty_region.max_row < buf_rows ? dirty_region.max_row
+                                                      : buf_rows - 1;
+        int min_col = dirty_region.min_col > 0 ? dirty_region.min_col : 0;
+        int max_col = dirty_region.max_col < buf_cols ? dirty_region.max_col
+                                                      : buf_cols - 1;
+
+        output_stats.dirty_cells +=
+            (uint64_t) (max_row - min_row + 1) * (max_col - min_col + 1);
+
+        for (int y = min_row; y <= max_row; y++) {
+            if (!row_has_changes(y, min_col, max_col))
+                continue;
+
+            int x = min_col;
+            while (x <= max_col) {
+                if (screen_buf[y][x] == prev_screen_buf[y][x] &&
+                    attr_buf[y][x] == prev_attr_buf[y][x]) {
+                    x++;
+                    continue;
+                }
+
+                /* Find end of the contiguous changed run */
+                int end_x = x;
+                while (end_x + 1 <= max_col &&
+                       (screen_buf[y][end_x + 1] !=
+                            prev_screen_buf[y][end_x + 1] ||
+                        attr_buf[y][end_x + 1] != prev_attr_buf[y][end_x + 1]))
+                    end_x++;
+
+                wire_encode_run(y, x, end_x);
+                has_changes = true;
+                x = end_x + 1;
+            }
+        }
+    }
+
+    wire_flush_spans();
+    TRACE_END("diff");
+
+    if (has_changes) {
+        wire_send_message(WIRE_MSG_FRAME, NULL, 0);
+        wire.frames++;
+        tui_force_flush();
+    }
+
+    reset_dirty_region();
+    return 0;
+}
+
+/* Parse complete client messages from the input buffer */
+static void wire_parse_input(void)
+{
+    size_t pos = 0;
+
+    while (wire.in_len - pos >= WIRE_HDR_SIZE) {
+        const uint8_t *msg = wire.in + pos;
+        size_t len = wire_get16(msg + 2);
+        if (wire.in_len - pos < WIRE_HDR_SIZE + len)
+            break; /* Incomplete message */
+
+        const uint8_t *payload = msg + WIRE_HDR_SIZE;
+        switch (msg[0]) {
+        case WIRE_MSG_KEY:
+            if (len >= 4) {
+                int next = (wire.key_tail + 1) % WIRE_KEY_QUEUE_SIZE;
+                if (next != wire.key_head) { /* Drop keys when full */
+                    wire.keys[wire.key_tail] = (int) wire_get32(payload);
+                    wire.key_tail = next;
+                }
+            }
+            break;
+        case WIRE_MSG_RESIZE:
+            if (len >= 4) {
+                wire.pending_rows = wire_get16(payload);
+                wire.pending_cols = wire_get16(payload + 2);
+                g_resize_requested = 1;
+            }
+            break;
+        case WIRE_MSG_QUIT:
+            g_shutdown_requested = SIGTERM;
+            break;
+        default:
+            break; /* Ignore unknown messages */
+        }
+
+        pos += WIRE_HDR_SIZE + len;
+    }
+
+    /* Keep the incomplete tail for the next read */
+    if (pos > 0) {
+        memmove(wire.in, wire.in + pos, wire.in_len - pos);
+        wire.in_len -= pos;
+    }
+}
+
+/* Read whatever the client sent, waiting at most timeout_ms */
+static void wire_read_input(int timeout_ms)
+{
+    struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+    if (poll(&pfd, 1, timeout_ms) <= 0)
+        return;
+
+    ssize_t n = read(STDIN_FILENO, wire.in + wire.in_len,
+                     sizeof(wire.in) - wire.in_len);
+    if (n > 0) {
+        wire.in_len += n;
+        wire_parse_input();
+    } else if (n == 0 || (errno != EINTR && errno != EAGAIN)) {
+        /* Client went away, treat it like a hangup */
+        g_shutdown_requested = SIGHUP;
+    }
+}
+
+static void wire_wait_for_client(void)
+{
+    uint64_t deadline = get_time_ms() + WIRE_HELLO_TIMEOUT_MS;
+
+    while (!wire.pending_rows && !g_shutdown_requested) {
+        uint64_t now = get_time_ms();
+        if (now >= deadline)
+            break;
+        wire_read_input((int) (deadline - now));
+    }
+
+    /* The initial size is consumed here rather than as a resize */
+    g_resize_requested = 0;
+    if (wire.pending_rows > 0 && wire.pending_cols > 0) {
+        tui_lines = (wire.pending_rows < 3) ? 3 : wire.pending_rows;
+        tui_cols = (wire.pending_cols < 10) ? 10 : wire.pending_cols;
+    }
+}
+
+static void wire_send_hello(void)
+{
+    uint8_t payload[10];
+    wire_put32(payload, WIRE_MAGIC);
+    wire_put16(payload + 4, WIRE_VERSION);
+    wire_put16(payload + 6, tui_lines);
+    wire_put16(payload + 8, tui_cols);
+    wire_send_message(WIRE_MSG_HELLO, payload, sizeof(payload));
+    wire_send_message(WIRE_MSG_CLEAR, NULL, 0);
+    tui_flush();
+}
+
+static int wire_getch(void)
+{
+    if (wire.key_head == wire.key_tail)
+        wire_read_input(tui_stdscr->delay == 0 ? 4 : tui_stdscr->delay);
+
+    if (wire.key_head == wire.key_tail)
+        return -1;
+
+    int key = wire.keys[wire.key_head];
+    wire.key_head = (wire.key_head + 1) % WIRE_KEY_QUEUE_SIZE;
+    return key;
+}
+
+static bool wire_has_input(void)
+{
+    if (wire.key_head != wire.key_tail)
+        return true;
+
+    struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+    return poll(&pfd, 1, 0) > 0;
+}
+
+/* Client side: apply one server message to the local screen */
+int tui_wire_apply(int type, const unsigned char *payload, size_t len)
+{
+    if (!screen_buf || !attr_buf)
+        return -1;
+
+    switch (type) {
+    case WIRE_MSG_COLOR:
+        if (len < 8)
+            return -1;
+        tui_init_color(wire_get16(payload), wire_get16(payload + 2),
+                       wire_get16(payload + 4), wire_get16(payload + 6));
+        break;
+
+    case WIRE_MSG_PAIR: {
+        if (len < 6)
+            return -1;
+        /* Mirror the server table verbatim, no lazy allocation */
+        uint16_t pair = wire_get16(payload);
+        if (pair >= TUI_COLOR_PAIRS)
+            return -1;
+        color_pairs[pair].fg = wire_get16(payload + 2);
+        color_pairs[pair].bg = wire_get16(payload + 4);
+        break;
+    }
+
+    case WIRE_MSG_SPANS: {
+        size_t pos = 0;
+        while (len - pos >= WIRE_SPAN_HDR_SIZE) {
+            int row = wire_get16(payload + pos);
+            int col = wire_get16(payload + pos + 2);
+            uint16_t count = wire_get16(payload + pos + 4);
+            bool fill = count & WIRE_SPAN_FILL;
+            int n = count & ~WIRE_SPAN_FILL;
+            size_t cells_len = (fill ? 1 : n) * WIRE_CELL_SIZE;
+            pos += WIRE_SPAN_HDR_SIZE;
+            if (len - pos < cells_len)
+                return -1;
+
+            /* Clip spans to the local grid */
+            if (row < buf_rows && col < buf_cols) {
+                int visible = (col + n > buf_cols) ? buf_cols - col : n;
+                for (int i = 0; i < visible; i++) {
+                    uint32_t cell = wire_get32(
+                        payload + pos + (fill ? 0 : i * WIRE_CELL_SIZE));
+                    screen_buf[row][col + i] = wire_cell_char(cell);
+                    attr_buf[row][col + i] = wire_cell_attr(cell);
+                }
+                if (visible > 0)
+                    mark_dirty_region(row, col, row, col + visible - 1);
+            }
+            pos += cells_len;
+        }
+        break;
+    }
+
+    case WIRE_MSG_CLEAR:
+        tui_clear_screen();
+        break;
+
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+static int refresh_window(tui_window_t *win)
 {
     if (!win || !screen_buf || !attr_buf || !prev_screen_buf || !prev_attr_buf)
         return -1;
 
+    /* Remote clients receive cell diffs for the whole screen */
+    if (g_backend == TUI_BACKEND_WIRE)
+        return wire_refresh();
+
     if (win == tui_stdscr) {
         /* Disable auto-flush during batch rendering for better performance */
         tui_set_auto_flush(false);
@@ -3202,6 +4241,10 @@ int tui_refresh(tui_window_t *win)
             return 0;
         }
 
+        /* Changed runs are encoded as they are found */
+        TRACE_BEGIN("diff");
+        frame_sync.armed = g_terminal_caps.supports_sync;
+
         /* Optimize dirty region to reduce unnecessary scanning */
         optimize_dirty_region();
 
@@ -3221,6 +4264,10 @@ int tui_refresh(tui_window_t *win)
         scan_min_col = scan_min_col < tui_cols ? scan_min_col : tui_cols - 1;
         scan_max_col = scan_max_col < tui_cols ? scan_max_col : tui_cols - 1;
 
+        output_stats.dirty_cells +=
+            (uint64_t) (scan_max_row - scan_min_row + 1) *
+            (scan_max_col - scan_min_col + 1);
+
         /* Adaptive scanning strategy selection */
         bool use_sparse_scanning = false;
         int sparse_tile_count = 0;
@@ -3268,7 +4315,11 @@ int tui_refresh(tui_window_t *win)
                  sparse_tile_count < tile_area / 2);
         }
 
-        if (use_sparse_scanning) {
+        if (back_buffer.spans) {
+            /* Whole rows against the back buffer, see diff_row_spans() */
+            for (int y = scan_min_row; y <= scan_max_row; y++)
+                diff_row_spans(y, &has_changes);
+        } else if (use_sparse_scanning) {
             /* Sparse scanning: iterate only through dirty tiles */
             dirty_region.total_scans++;
             dirty_region.sparse_hits++;
@@ -3433,86 +4484,12 @@ int tui_refresh(tui_window_t *win)
             }
         } else {
             /* Fallback: Traditional linear scanning with memcmp optimization */
-            for (int y = scan_min_row; y <= scan_max_row; y++) {
-                /* Fast row check: skip entire row if unchanged */
-                if (!row_has_changes(y, scan_min_col,
-                                     (scan_max_col < buf_cols)
-                                         ? scan_max_col
-                                         : buf_cols - 1)) {
-                    continue;
-                }
-
-                int x = scan_min_col;
-                while (x <= scan_max_col && x < buf_cols && x < tui_cols) {
-                    /* Check if cell has changed - now only for rows we know
-                     * have changes */
-                    if (screen_buf[y][x] != prev_screen_buf[y][x] ||
-                        attr_buf[y][x] != prev_attr_buf[y][x]) {
-                        has_changes = true;
-
-                        /* Find the start of changed region */
-                        int start_x = x;
-                        int curr_attr = attr_buf[y][x];
-
-                        /* Find end of run with same attributes that have
-                         * changed, with gap coalescing */
-                        int end_x = x;
-                        int unchanged_gap = 0;
-                        /* Coalesce if gap is 3 chars or less */
-                        const int MAX_GAP = 3;
-
-                        while (end_x + 1 < buf_cols && end_x + 1 < tui_cols &&
-                               attr_buf[y][end_x + 1] == curr_attr) {
-                            if (screen_buf[y][end_x + 1] !=
-                                    prev_screen_buf[y][end_x + 1] ||
-                                attr_buf[y][end_x + 1] !=
-                                    prev_attr_buf[y][end_x + 1]) {
-                                /* Changed cell - continue the run */
-                                end_x++;
-                                unchanged_gap = 0;
-                            } else if (unchanged_gap < MAX_GAP) {
-                                /* Small gap of unchanged cells - include in run
-                                 * to avoid cursor move */
-                                end_x++;
-                                unchanged_gap++;
-                            } else {
-                                /* Gap too large - end the run */
-                                break;
-                            }
-                        }
-
-                        /* Trim any trailing unchanged cells */
-                        while (end_x > x &&
-                               screen_buf[y][end_x] ==
-                                   prev_screen_buf[y][end_x] &&
-                               attr_buf[y][end_x] == prev_attr_buf[y][end_x]) {
-                            end_x--;
-                        }
-
-                        /* Move to start of changed run */
-                        tui_move_cached(y, start_x);
-
-                        /* Apply attributes for this run */
-                        apply_attributes(curr_attr);
-
-                        /* Output all changed characters in the run with
-                         * buffering optimization */
-                        output_buffered_run(y, start_x, end_x, screen_buf,
-                                            prev_screen_buf, prev_attr_buf);
-
-                        /* Update cached position after run */
-                        cursor_cache.last_col = end_x + 1;
-
-                        /* Move to next position */
-                        x = end_x + 1;
-                    } else {
-                        /* Cell unchanged, skip to next */
-                        x++;
-                    }
-                }
-            }
+            for (int y = scan_min_row; y <= scan_max_row; y++)
+                scan_row(y, scan_min_col, scan_max_col, &has_changes);
         }
 
+        TRACE_END("diff");
+
         /* Only flush if we actually rendered something */
         if (has_changes) {
             /* Reset to normal using pre-computed sequence */
@@ -3523,12 +4500,16 @@ int tui_refresh(tui_window_t *win)
                     intern_esc_sequence(ESC_RESET, strlen(ESC_RESET));
                 tui_puts(reset_seq);
             }
+            if (frame_sync.open)
+                tui_write(ESC_SYNC_END, sizeof(ESC_SYNC_END) - 1);
             tui_force_flush();
 
             /* Reset tracking states after rendering */
             reset_attr_state();
         }
 
+        frame_sync.armed = frame_sync.open = false;
+
         /* Re-enable auto-flush after batch rendering */
         tui_set_auto_flush(true);
 
@@ -3579,8 +4560,13 @@ int tui_refresh(tui_window_t *win)
                         /* Output all characters in the run */
                         for (int i = start_x; i <= end_x; i++) {
                             int sx = win->begx + i;
-                            if (sx >= 0 && sx < tui_cols && sx < buf_cols)
+                            if (sx >= 0 && sx < tui_cols && sx < buf_cols) {
                                 tui_putchar(screen_buf[screen_y][sx]);
+                                prev_screen_buf[screen_y][sx] =
+                                    screen_buf[screen_y][sx];
+                                prev_attr_buf[screen_y][sx] =
+                                    attr_buf[screen_y][sx];
+                            }
                         }
 
                         /* Update cached position after run */
@@ -3590,6 +4576,7 @@ int tui_refresh(tui_window_t *win)
                         x = end_x + 1;
                     }
                 }
+                back_buffer_forget_row(screen_y);
                 if (win->dirty)
                     win->dirty[y] = 0;
             }
@@ -3603,7 +4590,50 @@ int tui_refresh(tui_window_t *win)
     return 0;
 }
 
-/* Unused window functions removed - wnoutrefresh, doupdate, touchwin */
+int tui_refresh(tui_window_t *win)
+{
+    uint64_t dirty_cells = output_stats.dirty_cells;
+
+    PROBE(refresh_begin);
+    int ret = refresh_window(win);
+    PROBE1(refresh_end, output_stats.dirty_cells - dirty_cells);
+
+    return ret;
+}
+
+/**
+ * Publish the dirty rows of a deferred window to the screen
+ * @win : Window created by tui_newwin()
+ *
+ * Drawing into a deferred window only records dirty rows in the window. This
+ * folds them into the shared dirty region so that the next
+ * tui_refresh(tui_stdscr) diffs and flushes them together with everything
+ * else. Must be called from the thread that refreshes the screen.
+ */
+int tui_wnoutrefresh(tui_window_t *win)
+{
+    if (!win || !win->dirty)
+        return -1;
+
+    int col1 = win->begx > 0 ? win->begx : 0;
+    int col2 = win->begx + win->maxx;
+    if (col2 > buf_cols)
+        col2 = buf_cols;
+
+    for (int y = 0; y < win->maxy; y++) {
+        if (!win->dirty[y])
+            continue;
+        win->dirty[y] = 0;
+
+        int screen_y = win->begy + y;
+        if (screen_y >= 0 && screen_y < buf_rows && col1 < col2)
+            mark_dirty_region(screen_y, col1, screen_y, col2 - 1);
+    }
+
+    return 0;
+}
+
+/* Unused window functions removed - doupdate, touchwin */
 
 /* UTF-8 helper functions for proper Unicode character handling */
 static int utf8_char_length(unsigned char byte)
@@ -3688,14 +4718,20 @@ int tui_print_at(tui_window_t *win, int y, int x, const char *fmt, ...)
     int screen_y = win->begy + y;
     int screen_x = win->begx + x;
 
-    if (screen_y < 0 || screen_y >= buf_rows)
+    if (y < 0 || y >= win->maxy || screen_y < 0 || screen_y >= buf_rows)
         return -1;
 
+    /* Clip to the window as well as to the screen */
+    int min_x = win->begx > 0 ? win->begx : 0;
+    int max_x = win->begx + win->maxx;
+    if (max_x > buf_cols)
+        max_x = buf_cols;
+
     int start_x = screen_x;
 
     /* Process UTF-8 aware character-by-character */
     if (g_terminal_caps.supports_unicode) {
-        for (char *p = buffer; *p && screen_x < buf_cols;) {
+        for (char *p = buffer; *p && screen_x < max_x;) {
             int char_len = utf8_char_length((unsigned char) *p);
             int remaining = strlen(p);
 
@@ -3709,7 +4745,7 @@ int tui_print_at(tui_window_t *win, int y, int x, const char *fmt, ...)
                 char_len = 1; /* Fall back to single byte */
             }
 
-            if (screen_x >= 0) {
+            if (screen_x >= min_x) {
                 /* Store the complete UTF-8 sequence */
                 if (char_len == 1) {
                     /* ASCII character */
@@ -3718,9 +4754,9 @@ int tui_print_at(tui_window_t *win, int y, int x, const char *fmt, ...)
                     /* Multi-byte UTF-8 character - store first byte, mark
                      * others as continuation */
                     screen_buf[screen_y][screen_x] = *p;
-                    for (int i = 1; i < char_len && (screen_x + i) < buf_cols;
+                    for (int i = 1; i < char_len && (screen_x + i) < max_x;
                          i++) {
-                        if ((screen_x + i) >= 0) {
+                        if ((screen_x + i) >= min_x) {
                             screen_buf[screen_y][screen_x + i] = p[i];
                             attr_buf[screen_y][screen_x + i] =
                                 win->attr |
@@ -3731,15 +4767,18 @@ int tui_print_at(tui_window_t *win, int y, int x, const char *fmt, ...)
 
                 attr_buf[screen_y][screen_x] = win->attr;
 
-                /* Invalidate previous buffer entries */
-                if (prev_screen_buf && prev_attr_buf) {
-                    for (int i = 0; i < char_len && (screen_x + i) < buf_cols;
+                /* A multibyte character is rewritten whole, never from one
+                 * of its continuation cells
+                 */
+                if (char_len > 1 && prev_screen_buf && prev_attr_buf) {
+                    for (int i = 0; i < char_len && (screen_x + i) < max_x;
                          i++) {
-                        if ((screen_x + i) >= 0) {
+                        if ((screen_x + i) >= min_x) {
                             prev_screen_buf[screen_y][screen_x + i] = '\0';
                             prev_attr_buf[screen_y][screen_x + i] = 0xFFFFFFFF;
                         }
                     }
+                    back_buffer_forget_row(screen_y);
                 }
             }
 
@@ -3748,24 +4787,21 @@ int tui_print_at(tui_window_t *win, int y, int x, const char *fmt, ...)
         }
     } else {
         /* Fall back to byte-by-byte processing for non-UTF-8 terminals */
-        for (char *p = buffer; *p && screen_x < buf_cols; p++, screen_x++) {
-            if (screen_x >= 0) {
+        for (char *p = buffer; *p && screen_x < max_x; p++, screen_x++) {
+            if (screen_x >= min_x) {
                 screen_buf[screen_y][screen_x] = *p;
                 attr_buf[screen_y][screen_x] = win->attr;
-                /* Invalidate previous buffer entry to ensure redraw */
-                if (prev_screen_buf && prev_attr_buf) {
-                    prev_screen_buf[screen_y][screen_x] = '\0';
-                    prev_attr_buf[screen_y][screen_x] = 0xFFFFFFFF;
-                }
             }
         }
     }
 
     /* Mark the written region as dirty */
-    if (screen_x > start_x)
-        mark_dirty_region(screen_y, start_x, screen_y, screen_x - 1);
+    int mark_x1 = start_x > min_x ? start_x : min_x;
+    int mark_x2 = screen_x < max_x ? screen_x : max_x;
+    if (mark_x2 > mark_x1 && !win->deferred)
+        mark_dirty_region(screen_y, mark_x1, screen_y, mark_x2 - 1);
 
-    if (win->dirty && y < win->maxy)
+    if (win->dirty)
         win->dirty[y] = 1;
 
     win->cury = y;
@@ -3774,6 +4810,57 @@ int tui_print_at(tui_window_t *win, int y, int x, const char *fmt, ...)
     return 0;
 }
 
+/**
+ * Fill a rectangle of a window with one character in the current attribute
+ * @win : Window to draw into
+ * @y, @x : Top left cell, relative to the window
+ * @rows, @cols : Size of the rectangle
+ * @ch : Single-byte character
+ *
+ * Leaves the cells as printing @ch into each of them would, for the cost of
+ * one row fill per row.
+ */
+void tui_fill(tui_window_t *win, int y, int x, int rows, int cols, char ch)
+{
+    if (!win || !screen_buf || !attr_buf)
+        return;
+
+    /* Clip to the window as well as to the screen */
+    int min_x = win->begx > 0 ? win->begx : 0;
+    int max_x = win->begx + win->maxx;
+    if (max_x > buf_cols)
+        max_x = buf_cols;
+    int x1 = win->begx + x, x2 = x1 + cols;
+    if (x1 < min_x)
+        x1 = min_x;
+    if (x2 > max_x)
+        x2 = max_x;
+    if (x2 <= x1)
+        return;
+
+    int first = -1, last = -1;
+    for (int row = y; row < y + rows; row++) {
+        int screen_y = win->begy + row;
+        if (row < 0 || row >= win->maxy || screen_y < 0 ||
+            screen_y >= buf_rows)
+            continue;
+
+        memset(screen_buf[screen_y] + x1, ch, x2 - x1);
+        int *attrs = attr_buf[screen_y];
+        for (int i = x1; i < x2; i++)
+            attrs[i] = win->attr;
+
+        if (win->dirty)
+            win->dirty[row] = 1;
+        if (first < 0)
+            first = screen_y;
+        last = screen_y;
+    }
+
+    if (first >= 0 && !win->deferred)
+        mark_dirty_region(first, x1, last, x2 - 1);
+}
+
 int tui_wattron(tui_window_t *win, int attrs)
 {
     if (!win)
@@ -3806,3 +4893,77 @@ int tui_get_max_y(tui_window_t *win)
 {
     return win ? win->maxy : tui_lines;
 }
+
+/* Read a "Name:   1234 kB" line of /proc/self/status */
+static size_t proc_status_kb(const char *status, const char *name)
+{
+    const char *line = strstr(status, name);
+    return line ? strtoul(line + strlen(name), NULL, 10) : 0;
+}
+
+/**
+ * Report how much memory the renderer holds for this session
+ * @fp : Filled with the bytes reserved per table and the process RSS
+ *
+ * Pools that have not been needed yet count as zero.
+ */
+void tui_get_footprint(tui_footprint_t *fp)
+{
+    *fp = buf_arena.layout;
+
+    if (esc_seq_cache.pool)
+        fp->escapes += esc_seq_cache.pool_size * sizeof(esc_seq_entry_t);
+    if (esc_seq_cache.attr_combo_pool)
+        fp->escapes +=
+            esc_seq_cache.attr_combo_pool_size * sizeof(attr_combo_entry_t);
+    if (esc_lru_cache.entries)
+        fp->escapes += ESC_LRU_CACHE_SIZE * sizeof(esc_lru_entry_t);
+
+    fp->output = output_buffer.use_writev ? writev_buf.data_pool_size
+                                          : output_buffer.size;
+
+    fp->fixed = sizeof(esc_seq_cache) + sizeof(esc_lru_cache) +
+                sizeof(dirty_region) + sizeof(l1_tile_bitmap) +
+                sizeof(l2_block_bitmap) + sizeof(color_pair_cache) +
+                sizeof(color_pairs) + sizeof(color_defs) + sizeof(writev_buf) +
+                sizeof(output_buffer) + sizeof(cursor_cache);
+    if (color_pair_cache.nodes)
+        fp->fixed += color_pair_cache.node_count * sizeof(color_pair_node_t);
+    if (g_backend == TUI_BACKEND_WIRE)
+        fp->fixed += sizeof(wire);
+
+    fp->total = fp->screen + fp->cursor + fp->dirty + fp->escapes +
+                fp->output + fp->fixed;
+
+    char status[4096];
+    int fd = open("/proc/self/status", O_RDONLY | O_CLOEXEC);
+    ssize_t len = fd == -1 ? -1 : read(fd, status, sizeof(status) - 1);
+    if (fd != -1)
+        close(fd);
+    status[len > 0 ? len : 0] = '\0';
+
+    fp->rss_kb = proc_status_kb(status, "VmRSS:");
+    fp->anon_kb = proc_status_kb(status, "RssAnon:");
+    fp->peak_rss_kb = proc_status_kb(status, "VmHWM:");
+}
+
+void tui_get_stats(tui_stats_t *stats)
+{
+    stats->writes = output_stats.writes;
+    stats->bytes = output_stats.bytes;
+    stats->dirty_cells = output_stats.dirty_cells;
+    stats->esc_hits =
+        esc_seq_stats.cache_hits + esc_seq_stats.precomputed_hits;
+    stats->esc_misses = esc_seq_stats.cache_misses;
+    stats->pair_misses = color_pair_cache.cache_misses;
+    stats->vectors = writev_stats.total_vectors;
+    stats->short_writes =
+        writev_stats.partial_writes + writev_stats.fallback_writes;
+    stats->fill_runs =
+        rle_stats.char_runs_optimized + rle_stats.space_runs_optimized;
+    stats->fill_cells =
+        rle_stats.char_repeats_saved + rle_stats.space_chars_saved;
+    stats->esc_interned =
+        esc_seq_cache.pool_used + esc_seq_cache.attr_combo_pool_used;
+    stats->pairs_used = color_pair_cache.node_used;
+}
@@ -54,6 +54,7 @@ typedef struct {
     /* Terminal specific features */
     bool supports_ech;
     bool supports_rep;
+    bool supports_sync; /* Synchronized output, DEC private mode 2026 */
 
     /* Terminal identification */
     char term_name[64];
@@ -82,6 +83,7 @@ struct tui_window_t {
     int attr;
     int bkgd;
     unsigned char *dirty;
+    bool deferred; /* Dirty rows are published by tui_wnoutrefresh() */
 };
 
 /* Color pairs constant */
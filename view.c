@@ -0,0 +1,210 @@
+/*
+ * trex-view: thin client for "trex --serve-binary"
+ *
+ * Spawns the server command with its stdin/stdout connected to a socket,
+ * applies the binary cell diffs it streams to the local screen, and forwards
+ * decoded key presses and terminal size changes back. All VT encoding happens
+ * here, against the local terminal.
+ *
+ * Usage: trex-view [command [args...]]
+ *   The default command is "./trex --serve-binary". Remote play works by
+ *   passing e.g. "ssh host trex --serve-binary".
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "trex.h"
+#include "wire.h"
+
+#define VIEW_BUFFER_SIZE (2 * (WIRE_HDR_SIZE + WIRE_MAX_PAYLOAD))
+
+static int server_fd = -1;
+static bool server_gone = false;
+
+static void send_message(wire_msg_type_t type,
+                         const uint8_t *payload,
+                         size_t len)
+{
+    uint8_t buf[WIRE_HDR_SIZE + 8];
+    if (server_gone || len > sizeof(buf) - WIRE_HDR_SIZE)
+        return;
+
+    wire_put_hdr(buf, type, len);
+    if (len)
+        memcpy(buf + WIRE_HDR_SIZE, payload, len);
+
+    size_t total = WIRE_HDR_SIZE + len, sent = 0;
+    while (sent < total) {
+        /* MSG_NOSIGNAL: a dead server must not kill us with a raw tty */
+        ssize_t n = send(server_fd, buf + sent, total - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            server_gone = true;
+            return;
+        }
+        sent += n;
+    }
+}
+
+static void send_size(void)
+{
+    uint8_t payload[4];
+    wire_put16(payload, tui_get_max_y(tui_stdscr));
+    wire_put16(payload + 2, tui_get_max_x(tui_stdscr));
+    send_message(WIRE_MSG_RESIZE, payload, sizeof(payload));
+}
+
+static pid_t spawn_server(char *const argv[])
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1)
+        return -1;
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+
+    if (pid == 0) {
+        close(sv[0]);
+        dup2(sv[1], STDIN_FILENO);
+        dup2(sv[1], STDOUT_FILENO);
+        close(sv[1]);
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+
+    close(sv[1]);
+    server_fd = sv[0];
+    return pid;
+}
+
+/* Apply every complete message in buf, return the number of bytes used */
+static size_t process_messages(const uint8_t *buf, size_t len, bool *done)
+{
+    size_t pos = 0;
+
+    while (len - pos >= WIRE_HDR_SIZE) {
+        const uint8_t *msg = buf + pos;
+        size_t msg_len = wire_get16(msg + 2);
+        if (len - pos < WIRE_HDR_SIZE + msg_len)
+            break;
+
+        const uint8_t *payload = msg + WIRE_HDR_SIZE;
+        switch (msg[0]) {
+        case WIRE_MSG_HELLO:
+            if (msg_len < 6 || wire_get32(payload) != WIRE_MAGIC ||
+                wire_get16(payload + 4) != WIRE_VERSION)
+                *done = true;
+            break;
+        case WIRE_MSG_FRAME:
+            tui_refresh(tui_stdscr);
+            break;
+        case WIRE_MSG_BYE:
+            *done = true;
+            break;
+        default:
+            tui_wire_apply(msg[0], payload, msg_len);
+            break;
+        }
+
+        pos += WIRE_HDR_SIZE + msg_len;
+    }
+
+    return pos;
+}
+
+int main(int argc, char *argv[])
+{
+    static char *default_cmd[] = {"./trex", "--serve-binary", NULL};
+    char *const *cmd = (argc > 1) ? &argv[1] : default_cmd;
+
+    pid_t pid = spawn_server(cmd);
+    if (pid == -1) {
+        perror("trex-view: spawn");
+        return 1;
+    }
+
+    if (!tui_init()) {
+        fprintf(stderr, "trex-view: failed to initialize terminal\n");
+        kill(pid, SIGTERM);
+        return 1;
+    }
+    tui_raw();
+    tui_set_nodelay(tui_stdscr, true);
+    tui_set_keypad(tui_stdscr, true);
+    tui_noecho();
+    tui_set_cursor(0);
+    tui_start_color();
+    tui_cbreak();
+    tui_set_resize_hook(send_size);
+
+    send_size();
+
+    static uint8_t buf[VIEW_BUFFER_SIZE];
+    size_t buf_len = 0;
+    bool done = false;
+
+    while (!done && !server_gone) {
+        tui_check_shutdown();
+        tui_check_resize();
+
+        struct pollfd pfds[2] = {
+            {.fd = server_fd, .events = POLLIN},
+            {.fd = STDIN_FILENO, .events = POLLIN},
+        };
+        if (poll(pfds, 2, 100) < 0)
+            continue; /* EINTR from SIGWINCH */
+
+        /* Forward decoded keys to the server */
+        if (pfds[1].revents & POLLIN) {
+            while (tui_has_input()) {
+                int ch = tui_getch();
+                if (ch == -1)
+                    break;
+                uint8_t payload[4];
+                wire_put32(payload, (uint32_t) ch);
+                send_message(WIRE_MSG_KEY, payload, sizeof(payload));
+            }
+        }
+
+        /* Apply server diffs */
+        if (pfds[0].revents & (POLLIN | POLLHUP)) {
+            ssize_t n = read(server_fd, buf + buf_len, sizeof(buf) - buf_len);
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR)
+                    continue;
+                break;
+            }
+            buf_len += n;
+
+            size_t used = process_messages(buf, buf_len, &done);
+            memmove(buf, buf + used, buf_len - used);
+            buf_len -= used;
+        }
+    }
+
+    send_message(WIRE_MSG_QUIT, NULL, 0);
+    close(server_fd);
+    waitpid(pid, NULL, 0);
+
+    /* Finalize TUI */
+    tui_noraw();
+    tui_set_cursor(1);
+    tui_echo();
+    tui_clear_screen();
+    tui_cleanup();
+
+    return 0;
+}
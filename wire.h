@@ -0,0 +1,99 @@
+#pragma once
+
+/*
+ * Binary cell-diff protocol
+ *
+ * Used by "trex --serve-binary" and the trex-view thin client. Instead of VT
+ * bytes, the server streams the cells that changed since the last frame as
+ * run-length spans. The client applies them to its own grid and performs the
+ * VT encoding locally against its own terminal.
+ *
+ * Every message starts with a fixed 4-byte header:
+ *   [type:u8][reserved:u8][payload length:u16]
+ * All multi-byte integers are little-endian.
+ *
+ * A span payload is [row:u16][col:u16][count:u16] followed by the cells. When
+ * WIRE_SPAN_FILL is set in count, a single cell follows and is repeated,
+ * otherwise count cells follow. A cell is a u32 holding the attribute word in
+ * the upper 24 bits and the character in the low 8 bits.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WIRE_MAGIC 0x54524558u /* "TREX" */
+#define WIRE_VERSION 1
+
+#define WIRE_HDR_SIZE 4
+#define WIRE_MAX_PAYLOAD 0xFFFF
+#define WIRE_SPAN_HDR_SIZE 6
+#define WIRE_CELL_SIZE 4
+#define WIRE_SPAN_FILL 0x8000
+#define WIRE_SPAN_MAX_CELLS 0x7FFF
+
+/* Minimum run of identical cells worth encoding as a fill span */
+#define WIRE_FILL_MIN_RUN 4
+
+typedef enum {
+    /* Server to client */
+    WIRE_MSG_HELLO = 1, /* magic:u32 version:u16 rows:u16 cols:u16 */
+    WIRE_MSG_COLOR = 2, /* index:u16 r:u16 g:u16 b:u16 (0-1000 scale) */
+    WIRE_MSG_PAIR = 3,  /* pair:u16 fg:u16 bg:u16 */
+    WIRE_MSG_SPANS = 4, /* sequence of spans */
+    WIRE_MSG_FRAME = 5, /* end of frame, client should refresh */
+    WIRE_MSG_CLEAR = 6, /* client should invalidate its whole screen */
+    WIRE_MSG_BYE = 7,   /* server is shutting down */
+
+    /* Client to server */
+    WIRE_MSG_RESIZE = 64, /* rows:u16 cols:u16 */
+    WIRE_MSG_KEY = 65,    /* key:u32 */
+    WIRE_MSG_QUIT = 66,
+} wire_msg_type_t;
+
+static inline void wire_put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static inline void wire_put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static inline uint16_t wire_get16(const uint8_t *p)
+{
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static inline uint32_t wire_get32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) |
+           ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline void wire_put_hdr(uint8_t *p, wire_msg_type_t type, size_t len)
+{
+    p[0] = (uint8_t) type;
+    p[1] = 0;
+    wire_put16(p + 2, (uint16_t) len);
+}
+
+/* Pack character and attribute word into one cell */
+static inline uint32_t wire_pack_cell(char ch, int attr)
+{
+    return ((uint32_t) attr & ~0xFFu) | (uint8_t) ch;
+}
+
+static inline char wire_cell_char(uint32_t cell)
+{
+    return (char) (cell & 0xFF);
+}
+
+static inline int wire_cell_attr(uint32_t cell)
+{
+    return (int) (cell & ~0xFFu);
+}